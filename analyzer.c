@@ -3,6 +3,7 @@
 #include <stddef.h>
 #include "entropy.c"
 #include "analyzer.h"
+#include "score_table.h"
 #include <time.h>
 #include <stdio.h>
 #include <unistd.h>
@@ -11,109 +12,343 @@ double calculate_entropy(const char *buffer, size_t size);
 
 //행동(operation) 에 따라 가중치 부여
 //가중치 고려해야 할 점-> red 팀한테 코드 받아보고 평균적인 임계치랑 가중치 점수 수정해야
-#define WEIGTH_WRITE 1 //myfs_write 호출시 기본 점수 1
-#define WEIGTH_MALICIOUS 3 // myfs_unlink 나 _rename 호출시 점수 3 (더 많은 가중치 부여)
+#define WEIGHT_WRITE 1 //myfs_write 호출시 기본 점수 1
+#define WEIGHT_MALICIOUS 3 // myfs_unlink 나 _rename 호출시 점수 3 (더 많은 가중치 부여)
 #define WEIGHT_HIGH_ENTROPY 5 // 엔트로피 4.2 이상이면 5점 추가
 #define ENTROPY_THRESHOLD 4.2 // 대략적으로 정한 엔트로피 임계치
+#define WEIGHT_CIPHERTEXT 5 // 카이제곱/평균/상관계수까지 암호문처럼 보이면 5점 추가
+#define RANDOMNESS_MIN_BYTES 4096 // 이보다 작으면 카이제곱이 불안정해서 무작위성 검사 안 함
+#define CHI_SQUARE_MAX 350.0 // 자유도 255 카이제곱의 약 99.99% 상한 (압축 파일은 보통 수천 이상)
 
 
-//반복 행위에 대한  (빈도에 따라) 임계치
-#define TIME_SECONDS 1 // 1초ㄷ 단위 검사
-#define WRITE_THRESHOLE_PER_1 100 //1초에 write 100회까지
-#define UNLINK_THRESHOLE_PER_1 10 //1초에 unlink 10회까지
-#define RENAME_THRESHOLE_PER_1 10 //1초에 rename 10회까지
+//반복 행위에 대한  (빈도에 따라) 임계치 -> PID별 최근 1초 슬라이딩 윈도우 (RATE_BUCKETS x RATE_BUCKET_MS)
+#define WRITE_THRESHOLD_PER_1 100 //1초에 write 100회까지
+#define UNLINK_THRESHOLD_PER_1 10 //1초에 unlink 10회까지
+#define RENAME_THRESHOLD_PER_1 10 //1초에 rename 10회까지
 
 //빈도가 임계치 넘었을 때  추가 벌점
-#define PENALTY_HIGh_WRITE 50 // 쓰기 100회 넘었을 때 추가로 벌점 부여
-#define PENALTY_HIGh_UNLINK 100 // 언링크 10회 넘었을 때 추가 벌점
-#define PENALTY_HIGh_RENAME 100
+#define PENALTY_HIGH_WRITE 50 // 쓰기 100회 넘었을 때 추가로 벌점 부여
+#define PENALTY_HIGH_UNLINK 100 // 언링크 10회 넘었을 때 추가 벌점
+#define PENALTY_HIGH_RENAME 100
 
 #define FINAL_MALICE_THRESHOLD 200 // 총 누적 점수가 200이 넘으면 최종 악성 판단
-static int write_count = 0;
-static int unlink_count = 0;
-static int rename_count = 0;
-static int total_malice_score = 0;
-static time_t start_time = 0;
 
-static int get_score(const char* operation, const char* buf, size_t size) { //operation은 기본함수 구현하는 사람한테 받아와
-야함
-        int score_to_add = 0;
+//큰 write 버퍼는 일부 블록만 보고 엔트로피 추정 (기본은 꺼짐 = 전체 검사)
+#define SAMPLE_BLOCKS 16 // 표본 블록 개수
+#define SAMPLE_BLOCK_SIZE 4096 // 표본 블록 하나의 크기 (16 x 4KB = 64KB 만 읽음)
+static int sample_enabled = 0;
+static int sample_random = 0; // 0: 균등 간격, 1: 구간 안에서 무작위 위치
+static size_t sample_blocks = SAMPLE_BLOCKS;
+static size_t sample_block_size = SAMPLE_BLOCK_SIZE;
+static __thread uint64_t sample_seed = 0; // FUSE 스레드마다 따로 쓰는 난수 상태
+#define STREAM_MIN_BYTES 65536 // 누적 엔트로피로 판정하기 시작하는 최소 바이트 수 (64KB)
+/* 내용 점수 단위: write 하나가 이보다 크면 단위 개수만큼 곱함
+ * (max_write 1MB / writeback 캐시로 write 가 커져도 kill 까지 걸리는 바이트 수가 128KB 기본 크기 때와 같게) */
+#define WRITE_SCORE_UNIT (128 * 1024)
 
-        if (strcmp(operation, "WRITE") == 0) {
-                score_to_add += WEIGHT_WRITE; //1점주추가하기
+// 엔트로피 추정 모드 설정 (fuse 마운트 옵션에서 호출)
+void analyzer_set_entropy_sampling(int enabled, size_t blocks, size_t block_size, int randomized) {
+        sample_enabled = enabled;
+        sample_random = randomized;
+        if (blocks > 0) {
+                sample_blocks = blocks;
+        }
+        if (block_size > 0) {
+                sample_block_size = block_size;
+        }
+}
 
-                if (buf != NULL && size > 0) {
-                        double entropy = calculate_entropy(buf,size); //쓰기 했으니까 검사함
-                        if (entropy > ENTROPY_THRESHOLD) {
-                                score_to_add += WEIGTH_HIGH_ENTROPY; //5점 추가정
+/* write 버퍼 히스토그램 + 이웃 바이트 곱의 합 (한 번 순회)
+ * 표본 모드면 블록 몇 개만 세고, 추정값이 임계치 근처면 전체를 다시 셈
+ * 반환값: counts 에 들어간 바이트 수 */
+static uint64_t write_histogram(const char *buf, size_t size, uint64_t counts[256], uint64_t *serial_sum) {
+        memset(counts, 0, 256 * sizeof(uint64_t));
+        *serial_sum = 0;
 
-                        }
-                }
+        // 버퍼가 표본의 2배도 안 되면 표본으로 아낄 게 없음
+        if (!sample_enabled || size < 2 * sample_blocks * sample_block_size) {
+                entropy_histogram_serial(buf, size, counts, serial_sum);
+                return size;
+        }
 
+        uint64_t seed = 0;
+        if (sample_random) {
+                if (sample_seed == 0) {
+                        sample_seed = ((uint64_t)(uintptr_t)&sample_seed ^ (uint64_t)time(NULL)) | 1;
+                }
+                sample_seed = sample_seed * 6364136223846793005ULL + 1442695040888963407ULL;
+                seed = sample_seed | 1;
         }
 
-        else if (strcmp(operation, "UNLINK") == 0 || strcmp(operation, "RENAME") == 0) {
+        size_t sampled = entropy_sample_histogram(buf, size, sample_blocks, sample_block_size, seed, counts,
+                                                  serial_sum);
 
-                score_to_add += WEIGHT_MALICIOUS; //3점 추가
+        double estimate = entropy_from_counts(counts, sampled);
+        double bound = entropy_error_bound(counts, sampled);
+        if (fabs(estimate - ENTROPY_THRESHOLD) <= bound) { // 판정이 바뀔 수 있는 구간 -> 전체 검사
+                memset(counts, 0, 256 * sizeof(uint64_t));
+                *serial_sum = 0;
+                entropy_histogram_serial(buf, size, counts, serial_sum);
+                return size;
         }
-
-        return score_to_add; //일단은 쓰기, rename, unlink 만 점수부여 
+        return sampled;
 }
 
-//총 점수 계산 및 악성인지 판단하기 과정
-static int check_frequency_and_alert(){
-        time_t current_time = time(NULL);
-        int is_malicious = 0;
+void write_stream_init(WriteStream *stream) {
+        entropy_state_init(&stream->entropy);
+        stream->serial_sum = 0;
+        stream->next_offset = 0;
+}
 
-        if(start_time == 0) {
-                start_time = current_time;
-                return 0 ; // 첫 호출은 1초 대기
-        }
-        // 1초가 안 지났으면 검사 X
-        if (current_time - start_time < TIME_SECONDS){
+/* 암호문처럼 보이는지: 균등분포에 가까운 카이제곱 + 평균 127.5 + 이웃 바이트 무상관
+ * 압축 파일(동영상, zip)은 엔트로피는 높아도 카이제곱이 훨씬 커서 여기서 걸러짐
+ * 평균/상관계수 허용폭은 표본 크기에 맞춰 4 시그마 (평균의 표준편차 73.9/sqrt(n)) */
+static int looks_like_ciphertext(const RandomnessStats *stats, uint64_t n) {
+        if (n < RANDOMNESS_MIN_BYTES) {
                 return 0;
         }
-        // 임계치 넘으면 50점 벌점 추가
-             total_malice_score += PENALTY_HIGH_WRITE;
-        }
-        //임계치 넘으면 100점 벌점 추가
-        if (unlink_count > UNLINK_THRESHOLD_PER_1){
-                total_malice_score += PENALTY_HIGH_UNLILNK;
+        double sigma = 1.0 / sqrt((double)n);
+        return stats->chi_square < CHI_SQUARE_MAX &&
+               fabs(stats->mean - 127.5) < 4.0 * 73.9 * sigma &&
+               fabs(stats->serial_correlation) < 4.0 * sigma;
+}
+
+/* write 한 번의 점수
+ * stream 이 있으면 순차 write 들을 이어서 파일 전체의 누적 엔트로피로 판정 (청크 하나보다 덜 흔들림)
+ * 순차가 아닌 위치에 쓰면 누적 상태를 새로 시작함
+ * total: 원래 write 크기 (buf 가 표본이면 size 보다 큼, 점수는 원래 크기 단위로) */
+static int write_score(const char *buf, size_t size, size_t total, off_t offset, WriteStream *stream) {
+        int score_to_add = WEIGHT_WRITE; //1점주추가하기
+
+        if (buf == NULL || size == 0) {
+                return score_to_add;
         }
-        //임계치 넘으면 100점 벌점 추가
-        if (rename_count > RENAME_THRESHOLD_PER_1){
-                total_malice_score += PENALTY_HIGH_RENAME;
+
+        uint64_t counts[256];
+        uint64_t serial_sum;
+        uint64_t counted = write_histogram(buf, size, counts, &serial_sum); //쓰기 했으니까 검사함
+
+        RandomnessStats stats;
+        randomness_from_counts(counts, counted, serial_sum, &stats);
+        uint64_t stats_bytes = counted;
+
+        if (stream != NULL) {
+                if (offset != stream->next_offset) {
+                        entropy_state_init(&stream->entropy);
+                        stream->serial_sum = 0;
+                }
+                entropy_state_add(&stream->entropy, counts, counted);
+                stream->serial_sum += serial_sum;
+                stream->next_offset = offset + (off_t)total;
+
+                // 충분히 쌓였으면 청크 대신 파일 전체 누적값으로 판정
+                if (stream->entropy.total >= STREAM_MIN_BYTES) {
+                        randomness_from_counts(stream->entropy.counts, stream->entropy.total,
+                                               stream->serial_sum, &stats);
+                        stats_bytes = stream->entropy.total;
+                }
         }
-       // 전체 총합 점수가 임계치 넘으면 악성으로 판
-        if (total_malice_score > FINAL_MALICE_THRESHOLD) {
-                printf("헉!!!!!!");
-                printf("malice detected (PID:%d)\n", current_pid); //fuse 로부터 전달받아 저장해둔  공격자 pid
-                printf("malice score : %d (threshold: %d)\n", total_malice_score, FINAL_MALICE_THRESHOLD);
-                printf("각 행동 횟수 :(w : %d. U : %d, R:%d)\n", write_count, unlink_count, rename_count);
 
-                is_malicious = 1; // 악성으로 판정
+        int content_score = 0;
+        if (stats.entropy > ENTROPY_THRESHOLD) {
+                content_score += WEIGHT_HIGH_ENTROPY; //5점 추가정
+                if (looks_like_ciphertext(&stats, stats_bytes)) {
+                        content_score += WEIGHT_CIPHERTEXT;
                 }
-        // 다시 다음 1초를 위해 초기화해줌
-        total_malice_score = 0;
-        write_count = 0;
-        unlink_count = 0;
-        rename_count = 0;
-        start_time = current_time;
-        
-        return is_malicious;
+        }
+        size_t units = total > WRITE_SCORE_UNIT ? (total + WRITE_SCORE_UNIT - 1) / WRITE_SCORE_UNIT : 1;
+        return score_to_add + content_score * (int)units;
 }
 
-int monitor_operation(const char* operation, const char* buf, size_t size){
+int get_write_score(const char *buf, size_t size, off_t offset, WriteStream *stream) {
+        return write_score(buf, size, size, offset, stream);
+}
 
-        int content_score = get_score(operation, buf, size); //계산기로 단일 점수 계산
-        total_malice_score += content_score; // 장부에 점수와 횟수 누적
+// 연산 종류별 기본 가중치 (write 는 get_write_score 가 내용 검사 점수까지 더함)
+static const int op_weights[ANALYZER_OP_COUNT] = {
+        [ANALYZER_OP_WRITE] = WEIGHT_WRITE,
+        [ANALYZER_OP_UNLINK] = WEIGHT_MALICIOUS, //3점 추가
+        [ANALYZER_OP_RENAME] = WEIGHT_MALICIOUS,
+};
 
+int get_event_score(const AnalyzerEvent *ev) {
+        if (ev->op == ANALYZER_OP_WRITE) {
+                size_t total = ev->total_size > ev->size ? ev->total_size : ev->size;
+                return write_score(ev->buf, ev->size, total, ev->offset, ev->stream);
+        }
+        return op_weights[ev->op];
+}
+
+// 문자열 -> 연산 종류 (모르는 이름은 -1)
+static int op_from_name(const char *operation) {
         if (strcmp(operation, "WRITE") == 0) {
-                write_count++;
+                return ANALYZER_OP_WRITE;
         } else if (strcmp(operation, "UNLINK") == 0) {
-                unlink_count++;
+                return ANALYZER_OP_UNLINK;
         } else if (strcmp(operation, "RENAME") == 0) {
-                rename_count++;
+                return ANALYZER_OP_RENAME;
+        }
+        return -1;
+}
+
+int get_score(const char* operation, const char* buf, size_t size) { //operation은 기본함수 구현하는 사람한테 받아와야함
+        int op = op_from_name(operation);
+        if (op < 0) {
+                return 0; //일단은 쓰기, rename, unlink 만 점수부여
+        }
+        AnalyzerEvent ev = { .op = op, .buf = buf, .size = size };
+        return get_event_score(&ev);
+}
+
+// 연산 종류별 1초 임계치와 벌점
+static const uint32_t rate_thresholds[ANALYZER_OP_COUNT] = {
+        [ANALYZER_OP_WRITE] = WRITE_THRESHOLD_PER_1,
+        [ANALYZER_OP_UNLINK] = UNLINK_THRESHOLD_PER_1,
+        [ANALYZER_OP_RENAME] = RENAME_THRESHOLD_PER_1,
+};
+static const int rate_penalties[ANALYZER_OP_COUNT] = {
+        [ANALYZER_OP_WRITE] = PENALTY_HIGH_WRITE,
+        [ANALYZER_OP_UNLINK] = PENALTY_HIGH_UNLINK,
+        [ANALYZER_OP_RENAME] = PENALTY_HIGH_RENAME,
+};
+
+// 단조 시계 (ms). COARSE 는 커널이 틱마다 갱신해둔 값을 vDSO 로 읽기만 해서 시스템콜이 없음
+uint64_t analyzer_now_ms(void) {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+        return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+void rate_window_init(RateWindow *window) {
+        for (int op = 0; op < ANALYZER_OP_COUNT; op++) {
+                for (int b = 0; b < RATE_BUCKETS; b++) {
+                        atomic_init(&window->slots[op][b], 0);
+                }
+                atomic_init(&window->penalized_tick[op], 0);
+        }
+}
+
+/* 연산 한 번 기록 후 최근 1초(RATE_BUCKETS 칸) 합계 반환 - 할당 없음, 칸 수만큼의 고정 비용
+ * 칸 하나 = 상위 32비트 틱 번호 + 하위 32비트 횟수 -> CAS 한 번으로 오래된 칸 초기화와 증가를 같이 함 */
+uint32_t rate_window_hit(RateWindow *window, int op, uint64_t now_ms) {
+        uint32_t tick = (uint32_t)(now_ms / RATE_BUCKET_MS);
+        _Atomic uint64_t *slot = &window->slots[op][tick % RATE_BUCKETS];
+
+        uint64_t old = atomic_load_explicit(slot, memory_order_relaxed);
+        uint64_t next;
+        do {
+                if ((uint32_t)(old >> 32) == tick) {
+                        next = old + 1;
+                } else {
+                        next = ((uint64_t)tick << 32) | 1; // 한 바퀴 지난 칸 -> 새로 시작
+                }
+        } while (!atomic_compare_exchange_weak_explicit(slot, &old, next,
+                                                        memory_order_relaxed, memory_order_relaxed));
+
+        uint32_t total = 0;
+        for (int b = 0; b < RATE_BUCKETS; b++) {
+                uint64_t v = atomic_load_explicit(&window->slots[op][b], memory_order_relaxed);
+                if (tick - (uint32_t)(v >> 32) < RATE_BUCKETS) {
+                        total += (uint32_t)v;
+                }
+        }
+        return total;
+}
+
+/* 최근 1초 빈도가 임계치를 넘으면 벌점 (같은 연산은 1초에 한 번만)
+ * 1초 단위로 끊어 세던 방식과 달리 초 경계에 걸친 폭주도 잡힘 */
+static int rate_penalty(RateWindow *window, int op, uint64_t now_ms) {
+        uint32_t count = rate_window_hit(window, op, now_ms);
+        if (count <= rate_thresholds[op]) {
+                return 0;
+        }
+        uint32_t tick = (uint32_t)(now_ms / RATE_BUCKET_MS);
+        uint32_t last = atomic_load_explicit(&window->penalized_tick[op], memory_order_relaxed);
+        // 마지막 벌점 후 1초가 안 지났거나 다른 스레드가 먼저 가져갔으면 벌점 없음 (0 = 아직 없음)
+        if ((last != 0 && tick - last < RATE_BUCKETS) ||
+            !atomic_compare_exchange_strong(&window->penalized_tick[op], &last, tick ? tick : 1)) {
+                return 0;
+        }
+        return rate_penalties[op];
+}
+
+/* 잠긴 엔트리에 점수 반영 (호출자가 score_table_acquire 로 잡고 있어야 함)
+ * 반환: 반영 후 누적 점수 */
+int analyzer_apply(ProcessScore *entry, int op, int content_score, uint64_t now_ms) {
+        score_decay(entry, now_ms); // 지난 점수부터 반감기만큼 줄이고 더함
+        int before = (int)entry->malice_score;
+        entry->malice_score += content_score + rate_penalty(&entry->rate, op, now_ms);
+        int score = (int)entry->malice_score;
+
+        // 전체 총합 점수가 임계치 넘으면 악성으로 판단 (넘는 순간 한 번만 출력)
+        if (before <= FINAL_MALICE_THRESHOLD && score > FINAL_MALICE_THRESHOLD) {
+                fprintf(stderr, "malice detected (PID:%d) score : %d (threshold: %d)\n",
+                        entry->pid, score, FINAL_MALICE_THRESHOLD);
+        }
+        return score;
+}
+
+// PID 엔트리를 잡고 점수 반영 (content_score 는 get_score/get_write_score 결과)
+int analyzer_record(pid_t pid, int op, int content_score) {
+        uint64_t now = analyzer_now_ms();
+        ProcessScore *entry = score_table_acquire(pid, 1);
+        if (entry == NULL) {
+                return 0;
+        }
+        int score = analyzer_apply(entry, op, content_score, now);
+        score_table_release(entry);
+        return score;
+}
+
+// 점수 계산 + PID 누적 (빈도 벌점 포함). 반환: PID 누적 점수
+int monitor_event(const AnalyzerEvent *ev) {
+        return analyzer_record(ev->pid, ev->op, get_event_score(ev));
+}
+
+#define BATCH_CHUNK 64 // 내용 점수를 먼저 모아두는 단위 (스택에 둠)
+
+int monitor_batch(const AnalyzerEvent *events, size_t n, int *totals) {
+        int max_score = 0;
+        int content[BATCH_CHUNK];
+
+        for (size_t base = 0; base < n; base += BATCH_CHUNK) {
+                size_t count = n - base < BATCH_CHUNK ? n - base : BATCH_CHUNK;
+                const AnalyzerEvent *chunk = events + base;
+
+                // 무거운 내용 검사(히스토그램)는 락 밖에서 먼저
+                for (size_t i = 0; i < count; i++) {
+                        content[i] = get_event_score(&chunk[i]);
+                }
+
+                uint64_t now = analyzer_now_ms();
+                size_t i = 0;
+                while (i < count) {
+                        ProcessScore *entry = score_table_acquire(chunk[i].pid, 1);
+                        pid_t pid = chunk[i].pid;
+                        // 같은 PID 가 이어지는 동안은 엔트리를 잡은 채로 반영
+                        do {
+                                int score = entry != NULL ? analyzer_apply(entry, chunk[i].op, content[i], now) : 0;
+                                if (totals != NULL) {
+                                        totals[base + i] = score;
+                                }
+                                if (score > max_score) {
+                                        max_score = score;
+                                }
+                                i++;
+                        } while (i < count && chunk[i].pid == pid);
+                        if (entry != NULL) {
+                                score_table_release(entry);
+                        }
+                }
+        }
+        return max_score;
+}
+
+int monitor_operation(pid_t pid, const char* operation, const char* buf, size_t size){
+        int op = op_from_name(operation);
+        if (op < 0) {
+                return get_malice_score(pid);
         }
-        return check_frequency_and_alert(); //monitor 가 1초마다 검사하고 결과 반환 (악성이면 1)
+        AnalyzerEvent ev = { .op = op, .pid = pid, .buf = buf, .size = size };
+        return monitor_event(&ev); //계산기로 단일 점수 계산 후 누적
 }
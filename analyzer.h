@@ -1,6 +1,56 @@
 #ifndef ANALYZER_H
 #define ANALYZER_H
 #include <stddef.h>
+#include <sys/types.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include "entropy.h"
 
-int get_score(const char* operation, const char* buf, size_t size);
+// 분석하는 연산 종류 (가중치/빈도 표의 인덱스)
+typedef enum { ANALYZER_OP_WRITE, ANALYZER_OP_UNLINK, ANALYZER_OP_RENAME, ANALYZER_OP_COUNT } AnalyzerOp;
+
+// PID별 최근 1초 빈도 (125ms 칸 8개를 돌려 쓰는 슬라이딩 윈도우)
+#define RATE_BUCKETS 8
+#define RATE_BUCKET_MS 125
+typedef struct {
+        _Atomic uint64_t slots[ANALYZER_OP_COUNT][RATE_BUCKETS]; // 상위 32비트: 틱 번호, 하위 32비트: 횟수
+        _Atomic uint32_t penalized_tick[ANALYZER_OP_COUNT];      // 마지막으로 빈도 벌점 준 틱
+} RateWindow;
+
+// 열린 파일 하나의 순차 write 누적 상태 (fi->fh 에 달아서 사용)
+typedef struct {
+        EntropyState entropy;
+        uint64_t serial_sum; // 이웃 바이트 곱의 합 (상관계수용)
+        off_t next_offset; // 다음 순차 write 가 시작될 위치
+} WriteStream;
+
+// 분석기에 넘기는 이벤트 하나 (버퍼는 복사하지 않고 가리키기만 함)
+typedef struct {
+        AnalyzerOp op;
+        pid_t pid;
+        ino_t inode;          // 대상 파일 (0 = 모름)
+        off_t offset;         // write 위치
+        size_t size;          // buf 바이트 수
+        size_t total_size;    // 원래 write 크기 (buf 가 표본일 때 점수 단위/다음 위치 계산, 0 = size)
+        const char *buf;      // write 내용 (NULL 가능)
+        WriteStream *stream;  // 순차 write 누적 상태 (NULL 가능, 호출자가 잠가야 함)
+} AnalyzerEvent;
+
+int get_event_score(const AnalyzerEvent *ev); // 이벤트 하나의 내용 점수 (PID 누적 안 함)
+int monitor_event(const AnalyzerEvent *ev); // 점수 계산 + PID 누적, 누적 점수 반환
+/* 여러 이벤트를 한 번에 처리: 시계는 한 번만 읽고, 같은 PID 가 이어지면 엔트리 조회/락도 한 번
+ - totals 가 NULL 이 아니면 이벤트마다 반영 후 누적 점수를 채움
+ - 반환: 가장 높은 누적 점수 */
+int monitor_batch(const AnalyzerEvent *events, size_t n, int *totals);
+
+int get_score(const char* operation, const char* buf, size_t size); // 문자열 이름용 (이전 호출부 호환)
+void write_stream_init(WriteStream *stream);
+int get_write_score(const char *buf, size_t size, off_t offset, WriteStream *stream); // stream 은 NULL 가능
+int monitor_operation(pid_t pid, const char* operation, const char* buf, size_t size); // PID 누적 점수 반환
+int analyzer_record(pid_t pid, int op, int content_score); // 빈도 벌점 포함 PID 누적, 누적 점수 반환
+uint64_t analyzer_now_ms(void); // CLOCK_MONOTONIC_COARSE (ms)
+void rate_window_init(RateWindow *window);
+uint32_t rate_window_hit(RateWindow *window, int op, uint64_t now_ms); // 기록 후 최근 1초 횟수
+// 엔트로피 표본 추정 모드 (enabled=0 이면 항상 전체 검사, blocks/block_size 가 0이면 기본값)
+void analyzer_set_entropy_sampling(int enabled, size_t blocks, size_t block_size, int randomized);
 #endif
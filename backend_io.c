@@ -0,0 +1,283 @@
+#include "backend_io.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+#define BACKEND_IO_DEPTH_DEFAULT 64
+#define COPY_CHUNK (128 * 1024) // 등록 버퍼 하나 크기
+#define COPY_BUFS 8             // 한 번에 제출하는 읽기/쓰기 수 (링 크기보다 작아야 함)
+
+static atomic_int g_uring = 0; // 링 사용 중 (스레드에서 링 생성이 실패하면 끔)
+
+#ifdef HAVE_LIBURING
+static unsigned g_depth = BACKEND_IO_DEPTH_DEFAULT;
+static pthread_key_t g_ring_key;
+static pthread_once_t g_key_once = PTHREAD_ONCE_INIT;
+
+// 스레드 하나의 링
+typedef struct {
+    struct io_uring ring;
+    char *copy_mem; // COPY_BUFS x COPY_CHUNK, 처음 복사할 때 할당해서 등록
+    int copy_state; // 0 = 준비 안 함, 1 = 버퍼/파일 칸 등록됨, -1 = 등록 실패 (복사는 호출자가)
+} ThreadRing;
+
+// 스레드 종료 시 (libfuse 가 놀고 있는 워커 스레드를 정리할 때) 링 해제, 등록된 버퍼/파일도 같이 풀림
+static void thread_ring_free(void *arg) {
+    ThreadRing *tr = arg;
+    io_uring_queue_exit(&tr->ring);
+    free(tr->copy_mem);
+    free(tr);
+}
+
+static void ring_key_init(void) {
+    pthread_key_create(&g_ring_key, thread_ring_free);
+}
+
+// 이 스레드의 링 (없으면 생성, 못 만들면 NULL -> 시스템 콜)
+static ThreadRing *thread_ring(void) {
+    if (!atomic_load_explicit(&g_uring, memory_order_relaxed)) {
+        return NULL;
+    }
+    ThreadRing *tr = pthread_getspecific(g_ring_key);
+    if (tr != NULL) {
+        return tr;
+    }
+    tr = calloc(1, sizeof(*tr));
+    if (tr == NULL) {
+        return NULL;
+    }
+    int ret = io_uring_queue_init(g_depth, &tr->ring, 0);
+    if (ret < 0) {
+        free(tr);
+        fprintf(stderr, "INFO: io_uring 링 생성 실패 (%s), 시스템 콜로 전환\n", strerror(-ret));
+        atomic_store(&g_uring, 0);
+        return NULL;
+    }
+    pthread_setspecific(g_ring_key, tr);
+    return tr;
+}
+
+/* 준비된 SQE n 개를 한 번에 제출하고 완료를 모두 받음 (진입 1회)
+ - res[user_data] 에 결과 저장 */
+static int ring_run(ThreadRing *tr, unsigned n, int *res) {
+    int ret;
+    do {
+        ret = io_uring_submit_and_wait(&tr->ring, n); // EINTR 이면 제출은 됐고 대기만 다시
+    } while (ret == -EINTR);
+    if (ret < 0) {
+        return ret;
+    }
+    for (unsigned i = 0; i < n; i++) {
+        struct io_uring_cqe *cqe;
+        do {
+            ret = io_uring_wait_cqe(&tr->ring, &cqe);
+        } while (ret == -EINTR);
+        if (ret < 0) {
+            return ret;
+        }
+        res[io_uring_cqe_get_data64(cqe)] = cqe->res;
+        io_uring_cqe_seen(&tr->ring, cqe);
+    }
+    return 0;
+}
+
+// SQE 하나 실행, 결과를 시스템 콜 형식으로
+static ssize_t ring_run_one(ThreadRing *tr) {
+    int res = 0;
+    int ret = ring_run(tr, 1, &res);
+    if (ret < 0) {
+        errno = -ret;
+        return -1;
+    }
+    if (res < 0) {
+        errno = -res;
+        return -1;
+    }
+    return res;
+}
+
+// 복사용 등록 버퍼 COPY_BUFS 개 + 빈 등록 파일 칸 2개 (0 = 원본, 1 = 대상)
+static int ring_copy_setup(ThreadRing *tr) {
+    if (tr->copy_state != 0) {
+        return tr->copy_state > 0 ? 0 : -1;
+    }
+    tr->copy_state = -1;
+    if (posix_memalign((void **)&tr->copy_mem, 4096, (size_t)COPY_BUFS * COPY_CHUNK) != 0) {
+        tr->copy_mem = NULL;
+        return -1;
+    }
+    struct iovec iov[COPY_BUFS];
+    for (int i = 0; i < COPY_BUFS; i++) {
+        iov[i].iov_base = tr->copy_mem + (size_t)i * COPY_CHUNK;
+        iov[i].iov_len = COPY_CHUNK;
+    }
+    int files[2] = { -1, -1 };
+    if (io_uring_register_buffers(&tr->ring, iov, COPY_BUFS) < 0 ||
+        io_uring_register_files(&tr->ring, files, 2) < 0) {
+        fprintf(stderr, "INFO: io_uring 버퍼/파일 등록 실패, 복사는 read/write 사용\n");
+        return -1; // 버퍼만 등록된 경우는 링 해제 때 같이 풀림
+    }
+    tr->copy_state = 1;
+    return 0;
+}
+
+static int ring_copy(ThreadRing *tr, int src_fd, int dest_fd) {
+    int fds[2] = { src_fd, dest_fd };
+    if (io_uring_register_files_update(&tr->ring, 0, fds, 2) < 0) {
+        return BACKEND_IO_UNAVAILABLE;
+    }
+
+    int rres[COPY_BUFS], wres[COPY_BUFS];
+    off_t pos = 0;
+    int ret = 0, eof = 0;
+    while (!eof && ret == 0) {
+        // 읽기 COPY_BUFS 개를 pos 부터 이어서 한 번에
+        for (int i = 0; i < COPY_BUFS; i++) {
+            struct io_uring_sqe *sqe = io_uring_get_sqe(&tr->ring);
+            io_uring_prep_read_fixed(sqe, 0, tr->copy_mem + (size_t)i * COPY_CHUNK, COPY_CHUNK,
+                                     pos + (off_t)i * COPY_CHUNK, i);
+            io_uring_sqe_set_flags(sqe, IOSQE_FIXED_FILE);
+            io_uring_sqe_set_data64(sqe, i);
+        }
+        if ((ret = ring_run(tr, COPY_BUFS, rres)) < 0) {
+            break;
+        }
+
+        // 앞에서부터 이어진 부분만 씀 (짧게 읽힌 칸 뒤는 다음 바퀴에 그 위치부터 다시 읽음)
+        int n = 0;
+        off_t next = pos;
+        for (; n < COPY_BUFS; n++) {
+            if (rres[n] < 0) {
+                ret = rres[n];
+                break;
+            }
+            if (rres[n] == 0) {
+                eof = 1;
+                break;
+            }
+            next += rres[n];
+            if (rres[n] < COPY_CHUNK) {
+                n++;
+                break;
+            }
+        }
+        if (n == 0) {
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            struct io_uring_sqe *sqe = io_uring_get_sqe(&tr->ring);
+            io_uring_prep_write_fixed(sqe, 1, tr->copy_mem + (size_t)i * COPY_CHUNK, rres[i],
+                                      pos + (off_t)i * COPY_CHUNK, i);
+            io_uring_sqe_set_flags(sqe, IOSQE_FIXED_FILE);
+            io_uring_sqe_set_data64(sqe, i);
+        }
+        int wret = ring_run(tr, n, wres);
+        if (wret < 0) {
+            ret = wret;
+            break;
+        }
+        for (int i = 0; i < n && ret == 0; i++) {
+            if (wres[i] != rres[i]) {
+                ret = wres[i] < 0 ? wres[i] : -EIO; // 짧은 쓰기는 기존 복사 루프처럼 실패 처리
+            }
+        }
+        pos = next;
+    }
+
+    // 등록 파일은 파일 참조를 잡고 있으므로 호출자가 close 하기 전에 비움
+    int empty[2] = { -1, -1 };
+    io_uring_register_files_update(&tr->ring, 0, empty, 2);
+    if (ret < 0) {
+        errno = -ret;
+        return -1;
+    }
+    return 0;
+}
+#endif
+
+int backend_io_init(unsigned queue_depth) {
+#ifdef HAVE_LIBURING
+    pthread_once(&g_key_once, ring_key_init);
+    g_depth = queue_depth ? queue_depth : BACKEND_IO_DEPTH_DEFAULT;
+    if (g_depth < COPY_BUFS) {
+        g_depth = COPY_BUFS;
+    }
+    struct io_uring probe;
+    int ret = io_uring_queue_init(g_depth, &probe, 0);
+    if (ret < 0) {
+        fprintf(stderr, "INFO: io_uring 사용 불가 (%s), 시스템 콜 사용\n", strerror(-ret));
+        return -1;
+    }
+    io_uring_queue_exit(&probe);
+    atomic_store(&g_uring, 1);
+    return 0;
+#else
+    (void) queue_depth;
+    fprintf(stderr, "INFO: io_uring 지원 없이 빌드됨 (HAVE_LIBURING), 시스템 콜 사용\n");
+    return -1;
+#endif
+}
+
+const char *backend_io_name(void) {
+    return atomic_load(&g_uring) ? "io_uring" : "syscall";
+}
+
+ssize_t backend_io_pread(int fd, void *buf, size_t size, off_t offset) {
+#ifdef HAVE_LIBURING
+    ThreadRing *tr = thread_ring();
+    if (tr != NULL) {
+        struct io_uring_sqe *sqe = io_uring_get_sqe(&tr->ring);
+        io_uring_prep_read(sqe, fd, buf, size, offset);
+        io_uring_sqe_set_data64(sqe, 0);
+        return ring_run_one(tr);
+    }
+#endif
+    return pread(fd, buf, size, offset);
+}
+
+ssize_t backend_io_pwrite(int fd, const void *buf, size_t size, off_t offset) {
+#ifdef HAVE_LIBURING
+    ThreadRing *tr = thread_ring();
+    if (tr != NULL) {
+        struct io_uring_sqe *sqe = io_uring_get_sqe(&tr->ring);
+        io_uring_prep_write(sqe, fd, buf, size, offset);
+        io_uring_sqe_set_data64(sqe, 0);
+        return ring_run_one(tr);
+    }
+#endif
+    return pwrite(fd, buf, size, offset);
+}
+
+int backend_io_fsync(int fd, int datasync) {
+#ifdef HAVE_LIBURING
+    ThreadRing *tr = thread_ring();
+    if (tr != NULL) {
+        struct io_uring_sqe *sqe = io_uring_get_sqe(&tr->ring);
+        io_uring_prep_fsync(sqe, fd, datasync ? IORING_FSYNC_DATASYNC : 0);
+        io_uring_sqe_set_data64(sqe, 0);
+        return (int)ring_run_one(tr);
+    }
+#endif
+    return datasync ? fdatasync(fd) : fsync(fd);
+}
+
+int backend_io_copy(int src_fd, int dest_fd) {
+#ifdef HAVE_LIBURING
+    ThreadRing *tr = thread_ring();
+    if (tr != NULL && ring_copy_setup(tr) == 0) {
+        return ring_copy(tr, src_fd, dest_fd);
+    }
+#else
+    (void) src_fd;
+    (void) dest_fd;
+#endif
+    return BACKEND_IO_UNAVAILABLE;
+}
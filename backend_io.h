@@ -0,0 +1,29 @@
+#ifndef BACKEND_IO_H
+#define BACKEND_IO_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+/* 백엔드 파일 I/O 엔진
+ HAVE_LIBURING 으로 빌드하고 backend_io_init 이 성공하면 FUSE 스레드마다 io_uring 링을 하나씩 두고 제출,
+ 아니면 (빌드에 없음, 커널/seccomp 가 막음) 그냥 pread/pwrite/fsync 시스템 콜.
+ 반환값은 시스템 콜과 같음 (실패 시 -1 + errno) */
+
+#define BACKEND_IO_UNAVAILABLE 1 // backend_io_copy: 링을 못 씀 -> 호출자가 직접 복사
+
+/* 엔진 켜기 (링을 하나 만들어 보고 바로 닫음, 스레드별 링은 처음 쓸 때 생성)
+ - queue_depth: 링 크기 (0 = 기본값)
+ - 반환: 0 = io_uring 사용, -1 = 시스템 콜 사용 */
+int backend_io_init(unsigned queue_depth);
+const char *backend_io_name(void); // "io_uring" 또는 "syscall"
+
+ssize_t backend_io_pread(int fd, void *buf, size_t size, off_t offset);
+ssize_t backend_io_pwrite(int fd, const void *buf, size_t size, off_t offset);
+int backend_io_fsync(int fd, int datasync);
+
+/* src_fd 의 처음부터 끝까지를 dest_fd 의 같은 위치에 복사 (백업/복구용)
+ 읽기 여러 개를 한 번에 제출하고, 읽은 만큼 쓰기 여러 개를 한 번에 제출 (등록 버퍼 + 등록 파일)
+ - 반환: 0 = 성공, -1 = 실패 (errno), BACKEND_IO_UNAVAILABLE = 링 없음 */
+int backend_io_copy(int src_fd, int dest_fd);
+
+#endif
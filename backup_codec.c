@@ -0,0 +1,307 @@
+#include "backup_codec.h"
+#include "entropy.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#ifdef HAVE_LZ4
+#include <lz4.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#define CODEC_BLOCK (1024 * 1024)  // 블록 하나의 원래 크기
+#define PROBE_BLOCKS 8             // 엔트로피 표본 블록 수
+#define PROBE_BLOCK_SIZE 4096
+#define ENTROPY_ZSTD_MAX 6.0       // 이보다 낮으면 zstd (압축률 우선)
+#define ENTROPY_STORE_MIN 7.2      // 이보다 높으면 압축 안 함 (zip/jpg/암호문은 줄지 않음)
+#define ZSTD_LEVEL 3
+
+static const char CODEC_MAGIC[8] = { 'B', 'K', 'Z', 'P', 'A', 'C', 'K', '1' };
+
+typedef struct {
+    char magic[8];
+    uint32_t codec;
+    uint32_t block_size;
+    uint64_t orig_size;   // 원본 크기 (풀고 나서 확인)
+} PackHeader;
+
+enum { BLOCK_STORED, BLOCK_PACKED };
+
+typedef struct {
+    uint32_t raw_len;
+    uint32_t stored_len;
+    uint32_t type;       // BLOCK_STORED: 압축해도 안 줄어서 그대로
+    uint32_t reserved;
+} BlockHeader;
+
+static ssize_t pread_full(int fd, void *buf, size_t size, off_t offset) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = pread(fd, (char *)buf + done, size - done, offset + (off_t)done);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return n == 0 ? (ssize_t)done : -1;
+        }
+        done += n;
+    }
+    return done;
+}
+
+static int pwrite_full(int fd, const void *buf, size_t size, off_t offset) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = pwrite(fd, (const char *)buf + done, size - done, offset + (off_t)done);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return -1;
+        }
+        done += n;
+    }
+    return 0;
+}
+
+const char *codec_name(int codec) {
+    switch (codec) {
+    case CODEC_LZ4:
+        return "lz4";
+    case CODEC_ZSTD:
+        return "zstd";
+    default:
+        return "none";
+    }
+}
+
+int codec_choose(int src_fd, double *entropy_out) {
+    struct stat st;
+    if (fstat(src_fd, &st) == -1 || st.st_size == 0) {
+        return CODEC_NONE;
+    }
+
+    // 파일 전체에 고르게 흩어진 블록 몇 개만 읽음 (큰 파일도 32KB)
+    char buf[PROBE_BLOCK_SIZE];
+    uint64_t counts[256] = { 0 };
+    uint64_t total = 0;
+    off_t stride = st.st_size / PROBE_BLOCKS;
+    for (int i = 0; i < PROBE_BLOCKS; i++) {
+        ssize_t n = pread_full(src_fd, buf, sizeof(buf), stride * i);
+        if (n <= 0) {
+            break;
+        }
+        entropy_histogram(buf, n, counts);
+        total += n;
+        if (stride < PROBE_BLOCK_SIZE) {
+            break; // 작은 파일은 처음 블록이 전부
+        }
+    }
+    double entropy = total ? entropy_from_counts(counts, total) : 8.0;
+    if (entropy_out != NULL) {
+        *entropy_out = entropy;
+    }
+
+    if (entropy >= ENTROPY_STORE_MIN) {
+        return CODEC_NONE;
+    }
+#if defined(HAVE_ZSTD) && defined(HAVE_LZ4)
+    return entropy < ENTROPY_ZSTD_MAX ? CODEC_ZSTD : CODEC_LZ4;
+#elif defined(HAVE_ZSTD)
+    return CODEC_ZSTD;
+#elif defined(HAVE_LZ4)
+    return CODEC_LZ4;
+#else
+    return CODEC_NONE;
+#endif
+}
+
+// 압축 결과 최대 크기
+static size_t pack_bound(int codec, size_t size) {
+#ifdef HAVE_LZ4
+    if (codec == CODEC_LZ4) {
+        return LZ4_compressBound((int)size);
+    }
+#endif
+#ifdef HAVE_ZSTD
+    if (codec == CODEC_ZSTD) {
+        return ZSTD_compressBound(size);
+    }
+#endif
+    (void) codec;
+    return size;
+}
+
+int codec_pack(int src_fd, int dest_fd, int codec, uint64_t *packed_bytes) {
+    size_t bound = pack_bound(codec, CODEC_BLOCK);
+    char *in = malloc(CODEC_BLOCK);
+    char *out = malloc(bound);
+    int ret = -1;
+#ifdef HAVE_ZSTD
+    ZSTD_CCtx *zctx = codec == CODEC_ZSTD ? ZSTD_createCCtx() : NULL;
+    if (codec == CODEC_ZSTD && zctx == NULL) {
+        goto out;
+    }
+#endif
+    if (in == NULL || out == NULL) {
+        goto out;
+    }
+
+    PackHeader hdr = { .codec = codec, .block_size = CODEC_BLOCK };
+    memcpy(hdr.magic, CODEC_MAGIC, sizeof(hdr.magic));
+    off_t in_pos = 0, out_pos = sizeof(hdr);
+    for (;;) {
+        ssize_t n = pread_full(src_fd, in, CODEC_BLOCK, in_pos);
+        if (n < 0) {
+            goto out;
+        }
+        if (n == 0) {
+            break;
+        }
+        size_t packed = 0;
+#ifdef HAVE_LZ4
+        if (codec == CODEC_LZ4) {
+            int r = LZ4_compress_default(in, out, (int)n, (int)bound);
+            packed = r > 0 ? (size_t)r : 0;
+        }
+#endif
+#ifdef HAVE_ZSTD
+        if (codec == CODEC_ZSTD) {
+            size_t r = ZSTD_compressCCtx(zctx, out, bound, in, n, ZSTD_LEVEL);
+            packed = ZSTD_isError(r) ? 0 : r;
+        }
+#endif
+        // 안 줄어든 블록 (표본 밖의 압축된 부분 등) 은 그대로 저장
+        BlockHeader bh = { .raw_len = (uint32_t)n };
+        const char *data = in;
+        if (packed > 0 && packed < (size_t)n) {
+            bh.type = BLOCK_PACKED;
+            bh.stored_len = (uint32_t)packed;
+            data = out;
+        } else {
+            bh.type = BLOCK_STORED;
+            bh.stored_len = (uint32_t)n;
+        }
+        if (pwrite_full(dest_fd, &bh, sizeof(bh), out_pos) != 0 ||
+            pwrite_full(dest_fd, data, bh.stored_len, out_pos + sizeof(bh)) != 0) {
+            goto out;
+        }
+        out_pos += sizeof(bh) + bh.stored_len;
+        in_pos += n;
+    }
+
+    // 헤더는 크기를 알게 된 뒤 마지막에 씀 (중간에 끊기면 압축본으로 인식되지 않음)
+    hdr.orig_size = in_pos;
+    if (pwrite_full(dest_fd, &hdr, sizeof(hdr), 0) != 0 || ftruncate(dest_fd, out_pos) == -1) {
+        goto out;
+    }
+    if (packed_bytes != NULL) {
+        *packed_bytes = out_pos;
+    }
+    ret = 0;
+out:
+#ifdef HAVE_ZSTD
+    if (zctx != NULL) {
+        ZSTD_freeCCtx(zctx);
+    }
+#endif
+    free(in);
+    free(out);
+    return ret;
+}
+
+static int read_header(int fd, PackHeader *hdr) {
+    return pread_full(fd, hdr, sizeof(*hdr), 0) == sizeof(*hdr) &&
+           memcmp(hdr->magic, CODEC_MAGIC, sizeof(hdr->magic)) == 0 &&
+           hdr->codec <= CODEC_ZSTD && hdr->block_size > 0 && hdr->block_size <= 64 * CODEC_BLOCK;
+}
+
+int codec_is_packed(int fd) {
+    PackHeader hdr;
+    return read_header(fd, &hdr);
+}
+
+int codec_unpack(int src_fd, int dest_fd) {
+    PackHeader hdr;
+    if (!read_header(src_fd, &hdr)) {
+        return -1;
+    }
+#ifndef HAVE_LZ4
+    if (hdr.codec == CODEC_LZ4) {
+        fprintf(stderr, "RESTORE: lz4 압축본인데 lz4 없이 빌드됨\n");
+        return -1;
+    }
+#endif
+#ifndef HAVE_ZSTD
+    if (hdr.codec == CODEC_ZSTD) {
+        fprintf(stderr, "RESTORE: zstd 압축본인데 zstd 없이 빌드됨\n");
+        return -1;
+    }
+#endif
+    size_t bound = pack_bound(hdr.codec, hdr.block_size);
+    char *in = malloc(bound > hdr.block_size ? bound : hdr.block_size);
+    char *out = malloc(hdr.block_size);
+    int ret = -1;
+#ifdef HAVE_ZSTD
+    ZSTD_DCtx *zctx = hdr.codec == CODEC_ZSTD ? ZSTD_createDCtx() : NULL;
+    if (hdr.codec == CODEC_ZSTD && zctx == NULL) {
+        goto out;
+    }
+#endif
+    if (in == NULL || out == NULL) {
+        goto out;
+    }
+
+    off_t in_pos = sizeof(hdr), out_pos = 0;
+    while ((uint64_t)out_pos < hdr.orig_size) {
+        BlockHeader bh;
+        if (pread_full(src_fd, &bh, sizeof(bh), in_pos) != sizeof(bh) || bh.raw_len > hdr.block_size ||
+            bh.stored_len > (bh.type == BLOCK_STORED ? bh.raw_len : bound) ||
+            pread_full(src_fd, in, bh.stored_len, in_pos + sizeof(bh)) != (ssize_t)bh.stored_len) {
+            goto out;
+        }
+        const char *data = in;
+        if (bh.type == BLOCK_PACKED) {
+            size_t got = 0;
+#ifdef HAVE_LZ4
+            if (hdr.codec == CODEC_LZ4) {
+                int r = LZ4_decompress_safe(in, out, (int)bh.stored_len, (int)hdr.block_size);
+                got = r > 0 ? (size_t)r : 0;
+            }
+#endif
+#ifdef HAVE_ZSTD
+            if (hdr.codec == CODEC_ZSTD) {
+                size_t r = ZSTD_decompressDCtx(zctx, out, hdr.block_size, in, bh.stored_len);
+                got = ZSTD_isError(r) ? 0 : r;
+            }
+#endif
+            if (got != bh.raw_len) {
+                goto out;
+            }
+            data = out;
+        } else if (bh.type != BLOCK_STORED || bh.stored_len != bh.raw_len) {
+            goto out;
+        }
+        if (pwrite_full(dest_fd, data, bh.raw_len, out_pos) != 0) {
+            goto out;
+        }
+        in_pos += sizeof(bh) + bh.stored_len;
+        out_pos += bh.raw_len;
+    }
+    if ((uint64_t)out_pos == hdr.orig_size && ftruncate(dest_fd, out_pos) == 0) {
+        ret = 0;
+    }
+out:
+#ifdef HAVE_ZSTD
+    if (zctx != NULL) {
+        ZSTD_freeDCtx(zctx);
+    }
+#endif
+    free(in);
+    free(out);
+    return ret;
+}
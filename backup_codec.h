@@ -0,0 +1,28 @@
+#ifndef BACKUP_CODEC_H
+#define BACKUP_CODEC_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+/* 백업본 압축 (HAVE_LZ4 / HAVE_ZSTD 로 빌드했을 때)
+ 원본 몇 군데를 표본으로 읽어 엔트로피를 보고 파일마다 방식 선택:
+ - 낮음 (텍스트, 로그): zstd, 중간: lz4, 높음 (이미 압축/암호화된 데이터): 압축 안 함 (그냥 복사)
+ 압축본 형식: 헤더 + 1MB 블록 단위 [원래 길이, 저장 길이, 종류, 데이터] -> 메모리 일정하게 스트리밍 */
+
+enum { CODEC_NONE, CODEC_LZ4, CODEC_ZSTD };
+
+// 원본 표본 엔트로피로 방식 선택 (빌드에 없는 방식은 고르지 않음)
+int codec_choose(int src_fd, double *entropy_out);
+const char *codec_name(int codec);
+
+/* src_fd 처음부터 끝까지 압축해서 dest_fd 에 씀 (CODEC_NONE 이면 블록을 그대로 저장)
+ - 반환: 0 = 성공, -1 = 실패 / *packed_bytes 에 압축본 크기 */
+int codec_pack(int src_fd, int dest_fd, int codec, uint64_t *packed_bytes);
+
+// 압축본인지 (헤더 확인)
+int codec_is_packed(int fd);
+
+// 압축본을 블록마다 풀어서 dest_fd 의 원래 위치에 씀, 원래 크기로 맞춤
+int codec_unpack(int src_fd, int dest_fd);
+
+#endif
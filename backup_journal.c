@@ -0,0 +1,578 @@
+#include "backup_journal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <pthread.h>
+
+#define JOURNAL_DIR ".journal"          // 백업 디렉터리 아래 (이름 백업과 겹치지 않게, backup_index_load 가 건너뜀)
+#define WAL_NAME "backup.wal"
+#define SNAP_NAME "backup.idx"
+#define SNAP_TMP_NAME "backup.idx.tmp"
+#define WAL_MAGIC 0x324a4b42u           // "BKJ2" (경로 해시 추가 전 형식은 재생하지 않음)
+#define SNAP_MAGIC "BKIDX002"
+#define SNAP_MIN_CAP 1024
+#define CHECKPOINT_RECORDS 65536        // 재생한 COMPLETE 가 이만큼 넘으면 시작할 때 스냅샷 다시 씀
+#define UNFLUSHED_PROBE 256             // 저널 끝 뒤 번호의 임시 파일을 이만큼 연속으로 없을 때까지 찾음
+
+enum { JOURNAL_PENDING = 1, JOURNAL_COMPLETE = 2 };
+
+// 저널 레코드 (64 바이트 고정, 파일에 그대로 씀)
+typedef struct {
+    uint32_t magic;
+    uint32_t crc;       // crc 를 0 으로 두고 레코드 전체의 CRC32C (찢어진 마지막 레코드 검출)
+    uint64_t seq;       // 레코드 번호 (= 백업 버전, 계속 증가)
+    uint64_t ref;       // COMPLETE: 짝이 되는 PENDING 번호 (0 = 없음, 예전 백업 이전)
+    uint64_t dev;
+    uint64_t ino;
+    uint64_t size;
+    uint64_t name;
+    uint32_t gen;
+    uint8_t type;
+    uint8_t kind;
+    uint16_t pad;
+    uint32_t pad2;
+} WalRecord;
+
+// 스냅샷: 헤더 + cap 개 슬롯 (선형 탐사, 키는 dev/ino/kind -> gen 0 항목도 같은 탐사 경로)
+typedef struct {
+    char magic[8];
+    uint64_t cap;       // 2의 거듭제곱
+    uint64_t count;
+    uint64_t seq;       // 이 번호까지의 저널이 들어 있음 (재생 때 건너뜀)
+    uint64_t pad[4];
+} SnapHeader;
+
+typedef struct {
+    uint64_t dev;
+    uint64_t ino;
+    uint64_t size;
+    uint64_t name;
+    uint32_t gen;
+    uint8_t kind;
+    uint8_t used;
+    uint16_t pad;
+} SnapSlot;
+
+// 아직 파일에 안 쓴 레코드 (그룹 커밋 리더가 통째로 가져감)
+typedef struct {
+    WalRecord *r;
+    size_t count, cap;
+} Batch;
+
+static char g_dir[PATH_MAX];           // <백업dir>/.journal (저널, 스냅샷, 임시 파일)
+static int g_dir_fd = -1;
+static int g_backup_fd = -1;            // 백업 디렉터리 (확정된 백업본 link)
+static int g_wal_fd = -1;
+static off_t g_wal_size = 0;
+
+static const SnapHeader *g_snap = NULL;   // 읽기 전용 mmap (시작할 때만 바뀜)
+static size_t g_snap_bytes = 0;
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_cond = PTHREAD_COND_INITIALIZER;
+static Batch g_pend, g_spare;
+static uint64_t g_next_seq = 1;
+static uint64_t g_durable_seq = 0;        // 이 번호까지 fsync 끝남
+static uint64_t g_failed_lo = 1, g_failed_hi = 0; // 마지막으로 쓰기 실패한 묶음
+static int g_flushing = 0;
+static uint64_t g_records = 0, g_syncs = 0;
+
+static uint32_t g_crc_table[256];
+static pthread_once_t g_crc_once = PTHREAD_ONCE_INIT;
+
+static void crc_init_once(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) {
+            c = (c >> 1) ^ (0x82f63b78u & -(c & 1)); // CRC32C (Castagnoli)
+        }
+        g_crc_table[i] = c;
+    }
+}
+
+static uint32_t record_crc(const WalRecord *r) {
+    pthread_once(&g_crc_once, crc_init_once);
+    WalRecord tmp = *r;
+    tmp.crc = 0;
+    const unsigned char *p = (const unsigned char *)&tmp;
+    uint32_t c = 0xffffffffu;
+    for (size_t i = 0; i < sizeof(tmp); i++) {
+        c = g_crc_table[(c ^ p[i]) & 0xff] ^ (c >> 8);
+    }
+    return c ^ 0xffffffffu;
+}
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static uint64_t slot_hash(uint64_t dev, uint64_t ino, int kind) {
+    uint64_t h = ino * 0x9e3779b97f4a7c15ULL ^ dev * 0xc2b2ae3d27d4eb4fULL ^ (uint64_t)kind;
+    return h ^ (h >> 29);
+}
+
+static int slot_match(const SnapSlot *s, const JournalEntry *e) {
+    return s->dev == e->dev && s->ino == e->ino && s->kind == e->kind && s->name == e->name &&
+           (s->gen == e->gen || s->gen == 0 || e->gen == 0);
+}
+
+// 일치하는 슬롯 또는 빈 슬롯 (부하율 1/2 이하라 항상 빈 슬롯이 있음)
+static const SnapSlot *slot_probe(const SnapSlot *slots, uint64_t cap, const JournalEntry *e) {
+    uint64_t mask = cap - 1;
+    for (uint64_t i = slot_hash(e->dev, e->ino, e->kind) & mask;; i = (i + 1) & mask) {
+        if (!slots[i].used || slot_match(&slots[i], e)) {
+            return &slots[i];
+        }
+    }
+}
+
+static void snap_unmap(void) {
+    if (g_snap != NULL) {
+        munmap((void *)g_snap, g_snap_bytes);
+        g_snap = NULL;
+        g_snap_bytes = 0;
+    }
+}
+
+// 반환: 0 = 매핑함, 1 = 스냅샷 없음, -1 = 깨짐 (무시)
+static int snap_map(void) {
+    int fd = openat(g_dir_fd, SNAP_NAME, O_RDONLY);
+    if (fd == -1) {
+        return errno == ENOENT ? 1 : -1;
+    }
+    struct stat st;
+    void *mem = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(SnapHeader)) {
+        mem = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (mem == MAP_FAILED) {
+        return -1;
+    }
+    const SnapHeader *h = mem;
+    if (memcmp(h->magic, SNAP_MAGIC, 8) != 0 || h->cap == 0 || (h->cap & (h->cap - 1)) != 0 ||
+        h->count * 2 > h->cap || sizeof(SnapHeader) + h->cap * sizeof(SnapSlot) != (uint64_t)st.st_size) {
+        munmap(mem, st.st_size);
+        return -1;
+    }
+    madvise(mem, st.st_size, MADV_RANDOM);
+    g_snap = h;
+    g_snap_bytes = st.st_size;
+    return 0;
+}
+
+/* 스냅샷 다시 쓰기: 기존 스냅샷 + add -> backup.idx.tmp -> rename, 그 뒤 저널 비움
+ (rename 과 저널 비우기 사이에 죽어도 재생이 seq 로 이미 들어간 레코드를 건너뜀) */
+static int checkpoint(const JournalEntry *add, size_t n, uint64_t seq) {
+    uint64_t total = (g_snap ? g_snap->count : 0) + n;
+    uint64_t cap = SNAP_MIN_CAP;
+    while (cap < total * 2) {
+        cap <<= 1;
+    }
+    size_t bytes = sizeof(SnapHeader) + cap * sizeof(SnapSlot);
+    int fd = openat(g_dir_fd, SNAP_TMP_NAME, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd == -1) {
+        return -1;
+    }
+    void *mem = MAP_FAILED;
+    if (ftruncate(fd, bytes) == 0) {
+        mem = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (mem == MAP_FAILED) {
+        close(fd);
+        unlinkat(g_dir_fd, SNAP_TMP_NAME, 0);
+        return -1;
+    }
+    SnapHeader *h = mem;
+    SnapSlot *slots = (SnapSlot *)(h + 1);
+    uint64_t count = 0;
+    for (size_t i = 0; i < n; i++) {
+        SnapSlot *s = (SnapSlot *)slot_probe(slots, cap, &add[i]);
+        if (!s->used) {
+            *s = (SnapSlot){ .dev = add[i].dev, .ino = add[i].ino, .size = add[i].size, .name = add[i].name,
+                             .gen = add[i].gen, .kind = add[i].kind, .used = 1 };
+            count++;
+        }
+    }
+    if (g_snap != NULL) {
+        const SnapSlot *old = (const SnapSlot *)(g_snap + 1);
+        for (uint64_t i = 0; i < g_snap->cap; i++) {
+            if (!old[i].used) {
+                continue;
+            }
+            JournalEntry e = { .dev = old[i].dev, .ino = old[i].ino, .gen = old[i].gen, .kind = old[i].kind,
+                               .name = old[i].name };
+            SnapSlot *s = (SnapSlot *)slot_probe(slots, cap, &e);
+            if (!s->used) {
+                *s = old[i];
+                count++;
+            }
+        }
+    }
+    h->cap = cap;
+    h->count = count;
+    h->seq = seq;
+    memcpy(h->magic, SNAP_MAGIC, 8);
+    int ret = msync(mem, bytes, MS_SYNC) == 0 && fsync(fd) == 0 ? 0 : -1;
+    munmap(mem, bytes);
+    close(fd);
+    if (ret != 0 || renameat(g_dir_fd, SNAP_TMP_NAME, g_dir_fd, SNAP_NAME) != 0 || fsync(g_dir_fd) != 0) {
+        unlinkat(g_dir_fd, SNAP_TMP_NAME, 0);
+        return -1;
+    }
+    if (ftruncate(g_wal_fd, 0) == 0 && fdatasync(g_wal_fd) == 0) {
+        g_wal_size = 0;
+    }
+    snap_unmap();
+    return snap_map() == 0 ? 0 : -1;
+}
+
+#define PENDING_DONE (1ULL << 63) // 짝 COMPLETE 를 찾은 PENDING 표시 (정렬 순서는 그대로)
+
+static int seq_cmp(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a & ~PENDING_DONE, y = *(const uint64_t *)b & ~PENDING_DONE;
+    return x < y ? -1 : x > y;
+}
+
+static int grow(void **p, size_t *cap, size_t need, size_t elem) {
+    if (need <= *cap) {
+        return 0;
+    }
+    size_t n = *cap ? *cap * 2 : 1024;
+    while (n < need) {
+        n *= 2;
+    }
+    void *q = realloc(*p, n * elem);
+    if (q == NULL) {
+        return -1;
+    }
+    *p = q;
+    *cap = n;
+    return 0;
+}
+
+/* 저널 재생: 마지막으로 온전한 레코드까지 (그 뒤는 잘라냄)
+ - COMPLETE -> *added (스냅샷 seq 이후만), 짝 없는 PENDING -> 임시 파일 삭제 */
+static int wal_replay(JournalEntry **added, size_t *added_count, size_t *cleaned) {
+    struct stat st;
+    if (fstat(g_wal_fd, &st) == -1) {
+        return -1;
+    }
+    size_t n = st.st_size / sizeof(WalRecord);
+    uint64_t snap_seq = g_snap ? g_snap->seq : 0;
+    uint64_t max_seq = snap_seq;
+    uint64_t *pending = NULL;
+    size_t pending_count = 0, pending_cap = 0, added_cap = 0;
+    size_t valid = 0;
+
+    const WalRecord *rec = NULL;
+    if (n > 0) {
+        rec = mmap(NULL, n * sizeof(WalRecord), PROT_READ, MAP_PRIVATE, g_wal_fd, 0);
+        if (rec == MAP_FAILED) {
+            return -1;
+        }
+        madvise((void *)rec, n * sizeof(WalRecord), MADV_SEQUENTIAL);
+    }
+    for (; valid < n; valid++) {
+        const WalRecord *r = &rec[valid];
+        if (r->magic != WAL_MAGIC || r->crc != record_crc(r) ||
+            (r->type != JOURNAL_PENDING && r->type != JOURNAL_COMPLETE)) {
+            break;
+        }
+        if (r->seq > max_seq) {
+            max_seq = r->seq;
+        }
+        if (r->seq <= snap_seq) {
+            continue;
+        }
+        if (r->type == JOURNAL_PENDING) {
+            if (grow((void **)&pending, &pending_cap, pending_count + 1, sizeof(uint64_t)) == 0) {
+                pending[pending_count++] = r->seq;
+            }
+            continue;
+        }
+        if (r->ref != 0 && pending_count > 0) {
+            // PENDING 은 seq 순서로 쌓이므로 이분 탐색
+            uint64_t *p = bsearch(&r->ref, pending, pending_count, sizeof(uint64_t), seq_cmp);
+            if (p != NULL) {
+                *p |= PENDING_DONE;
+            }
+        }
+        if (grow((void **)added, &added_cap, *added_count + 1, sizeof(JournalEntry)) == 0) {
+            (*added)[(*added_count)++] = (JournalEntry){
+                .dev = r->dev, .ino = r->ino, .gen = r->gen, .kind = r->kind, .size = r->size, .name = r->name };
+        }
+    }
+    if (rec != NULL) {
+        munmap((void *)rec, n * sizeof(WalRecord));
+    }
+    if ((off_t)(valid * sizeof(WalRecord)) != st.st_size) {
+        fprintf(stderr, "JOURNAL: 저널 끝 %lld 바이트 잘라냄 (완전히 쓰이지 않은 레코드)\n",
+                (long long)(st.st_size - valid * sizeof(WalRecord)));
+        if (ftruncate(g_wal_fd, valid * sizeof(WalRecord)) != 0) {
+            fprintf(stderr, "JOURNAL: 저널 자르기 실패: %s\n", strerror(errno));
+        }
+    }
+    g_wal_size = valid * sizeof(WalRecord);
+
+    // 복사 중에 죽은 백업: 임시 파일만 지우면 다음 write 가 처음부터 다시 백업
+    for (size_t i = 0; i < pending_count; i++) {
+        if (pending[i] & PENDING_DONE) {
+            continue;
+        }
+        char name[64];
+        snprintf(name, sizeof(name), ".pending-%llu", (unsigned long long)pending[i]);
+        if (unlinkat(g_dir_fd, name, 0) == 0) {
+            (*cleaned)++;
+        }
+    }
+    free(pending);
+    /* PENDING 이 fsync 되기 전에 죽은 백업: 번호가 디스크에 남은 마지막 번호 바로 뒤라 그 근처만 확인
+     (그룹 커밋 사이에 쌓이는 레코드 수는 동시 백업 수 정도) */
+    for (uint64_t seq = max_seq + 1, miss = 0; miss < UNFLUSHED_PROBE; seq++) {
+        char name[64];
+        snprintf(name, sizeof(name), ".pending-%llu", (unsigned long long)seq);
+        if (unlinkat(g_dir_fd, name, 0) == 0) {
+            (*cleaned)++;
+            miss = 0;
+        } else {
+            miss++;
+        }
+    }
+    g_next_seq = max_seq + 1;
+    g_durable_seq = max_seq;
+    return 0;
+}
+
+int journal_open(const char *backup_dir, journal_entry_fn fn, void *arg) {
+    uint64_t start = now_us();
+    if (snprintf(g_dir, sizeof(g_dir), "%s/" JOURNAL_DIR, backup_dir) >= (int)sizeof(g_dir)) {
+        return -1;
+    }
+    g_backup_fd = open(backup_dir, O_RDONLY | O_DIRECTORY);
+    if (g_backup_fd == -1) {
+        return -1;
+    }
+    if (mkdirat(g_backup_fd, JOURNAL_DIR, 0700) == 0) {
+        fsync(g_backup_fd);
+    }
+    g_dir_fd = openat(g_backup_fd, JOURNAL_DIR, O_RDONLY | O_DIRECTORY);
+    if (g_dir_fd == -1) {
+        close(g_backup_fd);
+        g_backup_fd = -1;
+        return -1;
+    }
+    int snap = snap_map();
+    if (snap == -1) {
+        // 체크포인트 이전 저널은 이미 비웠으므로 호출자가 백업 디렉터리를 한 번 다시 읽어야 함
+        fprintf(stderr, "JOURNAL: 스냅샷이 깨짐, 지우고 백업 디렉터리를 다시 읽음\n");
+        unlinkat(g_dir_fd, SNAP_NAME, 0);
+    }
+    g_wal_fd = openat(g_dir_fd, WAL_NAME, O_RDWR | O_CREAT, 0600);
+    if (g_wal_fd == -1) {
+        snap_unmap();
+        close(g_dir_fd);
+        close(g_backup_fd);
+        g_dir_fd = g_backup_fd = -1;
+        return -1;
+    }
+
+    JournalEntry *added = NULL;
+    size_t added_count = 0, cleaned = 0;
+    if (wal_replay(&added, &added_count, &cleaned) != 0) {
+        free(added);
+        snap_unmap();
+        close(g_wal_fd);
+        close(g_dir_fd);
+        close(g_backup_fd);
+        g_wal_fd = g_dir_fd = g_backup_fd = -1;
+        return -1;
+    }
+    int fresh = snap == -1 || (snap == 1 && g_wal_size == 0);
+
+    // 재생 항목이 많으면 스냅샷에 합침 (다음 시작은 다시 mmap 만), 아니면 호출자 색인으로
+    int merged = 0;
+    if (added_count >= CHECKPOINT_RECORDS) {
+        merged = checkpoint(added, added_count, g_next_seq - 1) == 0;
+        if (!merged) {
+            fprintf(stderr, "JOURNAL: 체크포인트 실패, 저널 그대로 사용\n");
+        }
+    }
+    if (!merged && fn != NULL) {
+        for (size_t i = 0; i < added_count; i++) {
+            fn(&added[i], arg);
+        }
+    }
+    free(added);
+
+    fprintf(stderr, "JOURNAL: 스냅샷 %llu개 + 저널 %zu개 재생%s, 미완료 백업 %zu개 정리, %llu us\n",
+            (unsigned long long)(g_snap ? g_snap->count : 0), added_count, merged ? " (체크포인트)" : "",
+            cleaned, (unsigned long long)(now_us() - start));
+    return fresh;
+}
+
+// 락을 잡은 상태에서 호출, 반환: 레코드 번호 (0 = 메모리 부족)
+static uint64_t append_locked(WalRecord *r) {
+    if (grow((void **)&g_pend.r, &g_pend.cap, g_pend.count + 1, sizeof(WalRecord)) != 0) {
+        return 0;
+    }
+    r->magic = WAL_MAGIC;
+    r->seq = g_next_seq++;
+    r->crc = record_crc(r);
+    g_pend.r[g_pend.count++] = *r;
+    g_records++;
+    return r->seq;
+}
+
+static uint64_t append(WalRecord *r) {
+    pthread_mutex_lock(&g_lock);
+    uint64_t seq = append_locked(r);
+    pthread_mutex_unlock(&g_lock);
+    return seq;
+}
+
+// 묶음 쓰기: 디렉터리 fsync (link/unlink) 먼저, 그 뒤 저널 -> COMPLETE 가 남았으면 백업본 이름도 남아 있음
+static int wal_write(const WalRecord *r, size_t n, off_t off) {
+    const char *p = (const char *)r;
+    size_t left = n * sizeof(WalRecord);
+    while (left > 0) {
+        ssize_t w = pwrite(g_wal_fd, p, left, off);
+        if (w == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        p += w;
+        left -= w;
+        off += w;
+    }
+    return fsync(g_backup_fd) == 0 && fsync(g_dir_fd) == 0 && fdatasync(g_wal_fd) == 0 ? 0 : -1;
+}
+
+/* 그룹 커밋: seq 까지 디스크에 남을 때까지 기다림
+ - 쓰는 스레드가 없으면 이 스레드가 리더가 되어 그동안 쌓인 레코드를 전부 한 번에 쓰고 fsync
+ - 리더가 fsync 하는 동안 들어온 레코드는 다음 리더가 묶어서 씀 (fsync 수 = 레코드 수 / 동시 백업 수) */
+static int group_commit(uint64_t seq) {
+    pthread_mutex_lock(&g_lock);
+    while (g_durable_seq < seq) {
+        if (g_flushing) {
+            pthread_cond_wait(&g_cond, &g_lock);
+            continue;
+        }
+        Batch batch = g_pend;
+        g_pend = g_spare;
+        g_pend.count = 0;
+        uint64_t last = g_next_seq - 1;
+        off_t off = g_wal_size;
+        g_flushing = 1;
+        pthread_mutex_unlock(&g_lock);
+
+        int err = batch.count > 0 ? wal_write(batch.r, batch.count, off) : 0;
+
+        pthread_mutex_lock(&g_lock);
+        g_spare = batch;
+        g_flushing = 0;
+        if (err == 0) {
+            g_wal_size += batch.count * sizeof(WalRecord);
+            g_syncs++;
+        } else {
+            fprintf(stderr, "JOURNAL: 저널 쓰기 실패 (레코드 %zu개): %s\n", batch.count, strerror(errno));
+            g_failed_lo = g_durable_seq + 1;
+            g_failed_hi = last;
+        }
+        g_durable_seq = last;
+        pthread_cond_broadcast(&g_cond);
+    }
+    int ret = seq >= g_failed_lo && seq <= g_failed_hi ? -1 : 0;
+    pthread_mutex_unlock(&g_lock);
+    return ret;
+}
+
+int journal_begin(JournalTicket *t) {
+    if (g_wal_fd == -1) {
+        return -1;
+    }
+    WalRecord r = { .type = JOURNAL_PENDING };
+    t->seq = append(&r);
+    if (t->seq == 0) {
+        return -1;
+    }
+    if (snprintf(t->tmp_path, sizeof(t->tmp_path), "%s/.pending-%llu", g_dir,
+                 (unsigned long long)t->seq) >= (int)sizeof(t->tmp_path)) {
+        t->fd = -1;
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    // O_EXCL 아님: 같은 번호가 남아 있으면 PENDING 을 기록하기 전에 죽고 남은 찌꺼기
+    t->fd = open(t->tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    return t->fd == -1 ? -1 : 0;
+}
+
+int journal_commit(JournalTicket *t, const char *final_path, const JournalEntry *e, int ok) {
+    int ret = -1;
+    struct stat st;
+    uint64_t size = fstat(t->fd, &st) == 0 ? (uint64_t)st.st_size : 0;
+    if (ok && fdatasync(t->fd) == 0) {
+        if (link(t->tmp_path, final_path) == 0) {
+            ret = 0;
+        } else if (errno == EEXIST) {
+            ret = 1;
+        }
+    }
+    close(t->fd);
+    t->fd = -1;
+    unlink(t->tmp_path); // 확정됐으면 최종 이름이 남아 있음 (이 unlink 도 다음 그룹 커밋의 디렉터리 fsync 에 포함)
+    if (ret != 0) {
+        return ret;
+    }
+    WalRecord r = { .type = JOURNAL_COMPLETE, .ref = t->seq, .dev = e->dev, .ino = e->ino,
+                    .size = size, .name = e->name, .gen = e->gen, .kind = e->kind };
+    uint64_t seq = append(&r);
+    if (seq == 0 || group_commit(seq) != 0) {
+        // 백업본 자체는 확정됨 (재시작 후엔 색인에 없으니 다음 write 가 이미 있는 백업본을 확인)
+        fprintf(stderr, "JOURNAL: 경고: 완료 기록 실패: %s\n", final_path);
+    }
+    return 0;
+}
+
+void journal_record(const JournalEntry *e) {
+    if (g_wal_fd == -1) {
+        return;
+    }
+    WalRecord r = { .type = JOURNAL_COMPLETE, .dev = e->dev, .ino = e->ino,
+                    .size = e->size, .name = e->name, .gen = e->gen, .kind = e->kind };
+    append(&r);
+}
+
+int journal_sync(void) {
+    if (g_wal_fd == -1) {
+        return -1;
+    }
+    pthread_mutex_lock(&g_lock);
+    uint64_t seq = g_next_seq - 1;
+    pthread_mutex_unlock(&g_lock);
+    return group_commit(seq);
+}
+
+int journal_contains(const JournalEntry *e) {
+    if (g_snap == NULL) {
+        return 0;
+    }
+    return slot_probe((const SnapSlot *)(g_snap + 1), g_snap->cap, e)->used;
+}
+
+void journal_stats(uint64_t *records, uint64_t *syncs) {
+    pthread_mutex_lock(&g_lock);
+    if (records) *records = g_records;
+    if (syncs) *syncs = g_syncs;
+    pthread_mutex_unlock(&g_lock);
+}
@@ -0,0 +1,58 @@
+#ifndef BACKUP_JOURNAL_H
+#define BACKUP_JOURNAL_H
+
+#include <stdint.h>
+#include <limits.h>
+
+/* 백업 상태 저널 (이름 백업/inode 백업)
+ - 저널 파일은 전부 <백업dir>/.journal/ 아래 (백업본 이름과 겹치지 않음)
+ - .journal/backup.wal : 고정 크기 레코드 (PENDING = 복사 시작, COMPLETE = 백업본 확정), 레코드마다 CRC32C
+ - .journal/backup.idx : 체크포인트 스냅샷 (열린 주소 해시 테이블 그대로, 시작할 때 mmap 만 함)
+ - 복사는 .pending-<seq> 임시 파일에 -> fdatasync -> 최종 이름으로 link -> COMPLETE
+   (중간에 죽어도 잘린 백업본이 최종 이름으로 남아 O_EXCL 로 다음 백업을 막는 일이 없음)
+ - fsync 는 그룹 커밋: 먼저 온 스레드가 그동안 쌓인 레코드를 한 번에 쓰고 fsync, 나머지는 기다리기만 함
+ - 시작 시 백업 디렉터리를 읽지 않음: 스냅샷 mmap + 마지막 체크포인트 이후 저널만 재생,
+   COMPLETE 가 없는 PENDING 의 임시 파일만 지움 */
+
+typedef struct {
+    uint64_t dev;
+    uint64_t ino;
+    uint32_t gen;       // 0 = 모름 (아무 gen 과 일치)
+    uint8_t kind;       // 백업 방식 (restore.c 의 BACKUP_BY_NAME / BACKUP_BY_INODE)
+    uint64_t size;      // 백업본 크기 (journal_commit 이 채움, 조회 때는 무시)
+    uint64_t name;      // 이름 백업의 경로 해시 (inode 백업은 0)
+} JournalEntry;
+
+typedef struct {
+    int fd;                     // 백업 내용을 쓸 fd (journal_commit 이 닫음)
+    uint64_t seq;               // PENDING 레코드 번호
+    char tmp_path[PATH_MAX];    // .pending-<seq>
+} JournalTicket;
+
+// 재생한 COMPLETE 항목 (스냅샷에 합치지 않은 것만) 마다 호출
+typedef void (*journal_entry_fn)(const JournalEntry *e, void *arg);
+
+/* 저널 열기 + 재생 (restore_init 에서, 다른 스레드가 쓰기 전에 호출)
+ - 재생할 저널이 많으면 체크포인트 (스냅샷 다시 쓰고 저널 비움)
+ - 반환: 0 = 기존 저널, 1 = 처음 (스냅샷/저널 없음 -> 호출자가 예전 백업본을 한 번 스캔해서 journal_record), -1 = 실패 */
+int journal_open(const char *backup_dir, journal_entry_fn fn, void *arg);
+
+// 백업 시작: PENDING 기록 (기다리지 않음) + 임시 파일 생성, 반환: 0 = t->fd 에 쓰면 됨, -1 = 실패
+int journal_begin(JournalTicket *t);
+/* 백업 끝: ok 이면 fdatasync 후 final_path 로 link, COMPLETE 기록 후 그룹 커밋까지 기다림
+ - 임시 파일은 항상 지움
+ - 반환: 0 = 새 백업본 확정, 1 = final_path 가 이미 있음 (이번 복사본은 버림), -1 = 실패 */
+int journal_commit(JournalTicket *t, const char *final_path, const JournalEntry *e, int ok);
+
+// 이미 있는 백업본을 COMPLETE 로 기록 (예전 백업 디렉터리 이전용, 기다리지 않음 -> 끝나면 journal_sync)
+void journal_record(const JournalEntry *e);
+// 지금까지 기록한 레코드를 디스크에 (0 = 성공)
+int journal_sync(void);
+
+// 스냅샷에 있는 백업인지 (락 없음, 마지막 체크포인트 이후 항목은 호출자 색인에 있음)
+int journal_contains(const JournalEntry *e);
+
+// 기록한 레코드 수, fsync 횟수 (그룹 커밋이 몇 개씩 묶었는지)
+void journal_stats(uint64_t *records, uint64_t *syncs);
+
+#endif
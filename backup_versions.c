@@ -0,0 +1,613 @@
+#include "backup_versions.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h> // FICLONE
+#include <pthread.h>
+
+#define VERSIONS_BUCKETS_INITIAL 1024
+#define EVICT_INTERVAL_S 60        // 보관 기간 검사 주기
+#define EVICT_LOW_PERCENT 90       // 한도를 넘으면 한도의 90% 까지 줄임 (매 백업마다 깨지 않도록)
+#define SIZE_WEIGHT_MS 60000       // 1MB 마다 1분 더 오래 안 쓴 것으로 취급 (큰 버전부터 공간 회수)
+
+typedef struct {
+    uint64_t created_ms;    // 파일 이름의 시각 (벽시계, 재시작 후에도 유지)
+    uint64_t used_ms;       // 마지막 사용 (만들었거나 복구에 씀)
+    uint64_t size;
+    pid_t pid;
+    int quarantined;        // 삭제/덮어쓰기 직전 파일 자체 (이름 끝 -q, quarantine_age 지나면 최신이어도 정리)
+} Version;
+
+// 경로 하나의 버전들 (created_ms 오름차순)
+typedef struct VersionFile {
+    uint64_t key;
+    char *relpath;
+    uint64_t next_ms;       // 다음 버전 이름으로 줄 시각 (같은 ms 에 두 번 만들어도 겹치지 않게)
+    Version *v;
+    size_t count, cap;
+    struct VersionFile *next;
+} VersionFile;
+
+// 버전 파일 경로에서 g_dir 뒤에 붙는 최대 길이: "/<키 16자>/<ms 20자>-<pid 11자>-q.part"
+#define VERSION_PATH_TAIL 64
+static char g_dir[PATH_MAX - VERSION_PATH_TAIL];
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_cond = PTHREAD_COND_INITIALIZER;
+static VersionFile **g_buckets = NULL;
+static size_t g_bucket_count = 0, g_file_count = 0;
+static uint64_t g_total_bytes = 0, g_version_count = 0, g_evicted = 0;
+static uint64_t g_quota = 0;
+static unsigned g_max_age_s = 0;
+static unsigned g_quarantine_age_s = 0;
+
+static uint64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// 경로 해시 (FNV-1a)
+static uint64_t path_key(const char *path) {
+    uint64_t h = 1469598103934665603ULL;
+    for (const unsigned char *p = (const unsigned char *)path; *p; p++) {
+        h ^= *p;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static void file_dir(char *out, uint64_t key) {
+    snprintf(out, PATH_MAX, "%s/%016llx", g_dir, (unsigned long long)key);
+}
+
+static void version_path(char *out, uint64_t key, uint64_t created_ms, pid_t pid, int quarantined) {
+    snprintf(out, PATH_MAX, "%s/%016llx/%013llu-%d%s", g_dir, (unsigned long long)key,
+             (unsigned long long)created_ms, (int)pid, quarantined ? "-q" : "");
+}
+
+// 아래 목록 함수는 g_lock 잡은 상태에서 호출
+static VersionFile *file_find(uint64_t key) {
+    if (g_bucket_count == 0) {
+        return NULL;
+    }
+    for (VersionFile *vf = g_buckets[key & (g_bucket_count - 1)]; vf != NULL; vf = vf->next) {
+        if (vf->key == key) {
+            return vf;
+        }
+    }
+    return NULL;
+}
+
+static int buckets_grow(void) {
+    size_t cap = g_bucket_count ? g_bucket_count * 2 : VERSIONS_BUCKETS_INITIAL;
+    VersionFile **buckets = calloc(cap, sizeof(VersionFile *));
+    if (buckets == NULL) {
+        return -1;
+    }
+    for (size_t i = 0; i < g_bucket_count; i++) {
+        VersionFile *vf = g_buckets[i];
+        while (vf != NULL) {
+            VersionFile *next = vf->next;
+            vf->next = buckets[vf->key & (cap - 1)];
+            buckets[vf->key & (cap - 1)] = vf;
+            vf = next;
+        }
+    }
+    free(g_buckets);
+    g_buckets = buckets;
+    g_bucket_count = cap;
+    return 0;
+}
+
+static VersionFile *file_add(uint64_t key, const char *relpath) {
+    if (g_file_count >= g_bucket_count && buckets_grow() != 0) {
+        return NULL;
+    }
+    VersionFile *vf = calloc(1, sizeof(*vf));
+    if (vf == NULL || (vf->relpath = strdup(relpath)) == NULL) {
+        free(vf);
+        return NULL;
+    }
+    vf->key = key;
+    vf->next = g_buckets[key & (g_bucket_count - 1)];
+    g_buckets[key & (g_bucket_count - 1)] = vf;
+    g_file_count++;
+    return vf;
+}
+
+// created_ms 순서를 지키며 추가 (동시에 만든 버전은 확정 순서가 바뀔 수 있음)
+static int version_add(VersionFile *vf, const Version *v) {
+    if (vf->count == vf->cap) {
+        size_t cap = vf->cap ? vf->cap * 2 : 4;
+        Version *nv = realloc(vf->v, cap * sizeof(Version));
+        if (nv == NULL) {
+            return -1;
+        }
+        vf->v = nv;
+        vf->cap = cap;
+    }
+    size_t i = vf->count;
+    while (i > 0 && vf->v[i - 1].created_ms > v->created_ms) {
+        vf->v[i] = vf->v[i - 1];
+        i--;
+    }
+    vf->v[i] = *v;
+    vf->count++;
+    if (v->created_ms >= vf->next_ms) {
+        vf->next_ms = v->created_ms + 1;
+    }
+    g_total_bytes += v->size;
+    g_version_count++;
+    return 0;
+}
+
+static void version_remove(VersionFile *vf, uint64_t created_ms) {
+    for (size_t i = 0; i < vf->count; i++) {
+        if (vf->v[i].created_ms == created_ms) {
+            g_total_bytes -= vf->v[i].size;
+            g_version_count--;
+            memmove(&vf->v[i], &vf->v[i + 1], (vf->count - i - 1) * sizeof(Version));
+            vf->count--;
+            return;
+        }
+    }
+}
+
+/* 정리 후보 (버전 하나)
+ - newest: 파일의 최신 버전 (한도를 못 맞출 때만 지움)
+ - run_start: 어떤 pid 가 연달아 만든 버전 중 첫 번째 = 그 pid 가 쓰기 전 내용 (version_pick 이 복구에 고르는 것)
+   -> 같은 pid 가 뒤에 계속 만든 버전 (이미 암호화됐을 수 있음) 을 먼저 지우고,
+      같은 파일에서 뒤에 만든 버전보다 먼저 지우지 않음 */
+typedef struct {
+    VersionFile *vf;
+    uint64_t created_ms;
+    uint64_t size;
+    int64_t score;          // 작을수록 먼저 지움
+    pid_t pid;
+    int quarantined;
+    int newest;
+    int run_start;
+    int victim;
+} EvictCandidate;
+
+static int candidate_cmp(const void *a, const void *b) {
+    const EvictCandidate *x = a, *y = b;
+    if (x->newest != y->newest) {
+        return x->newest - y->newest;
+    }
+    if (x->run_start != y->run_start) {
+        return x->run_start - y->run_start;
+    }
+    if (x->score != y->score) {
+        return (x->score > y->score) - (x->score < y->score);
+    }
+    return (x->created_ms < y->created_ms) - (x->created_ms > y->created_ms); // 같으면 새 버전부터
+}
+
+typedef struct {
+    uint64_t key;
+    uint64_t created_ms;
+    pid_t pid;
+    int quarantined;
+} Victim;
+
+/* 지울 버전 고르고 목록에서 뺌 (파일 삭제는 락 밖에서)
+ - 보관 기간 지난 버전 (최신 제외), 격리 기간 지난 격리본 (최신이어도) -> 한도 넘으면 점수 낮은 순으로 한도의 90% 까지 */
+static size_t evict_select(Victim **out) {
+    *out = NULL;
+    if (g_version_count == 0) {
+        return 0;
+    }
+    EvictCandidate *cand = malloc(g_version_count * sizeof(EvictCandidate));
+    if (cand == NULL) {
+        return 0;
+    }
+    uint64_t now = now_ms();
+    size_t n = 0;
+    for (size_t b = 0; b < g_bucket_count; b++) {
+        for (VersionFile *vf = g_buckets[b]; vf != NULL; vf = vf->next) {
+            size_t first = n;
+            for (size_t i = 0; i < vf->count; i++) {
+                const Version *v = &vf->v[i];
+                EvictCandidate *c = &cand[n++];
+                c->vf = vf;
+                c->created_ms = v->created_ms;
+                c->size = v->size;
+                c->pid = v->pid;
+                c->quarantined = v->quarantined;
+                c->score = (int64_t)v->used_ms - (int64_t)(v->size >> 20) * SIZE_WEIGHT_MS;
+                c->newest = i + 1 == vf->count;
+                c->run_start = i == 0 || vf->v[i - 1].pid != v->pid;
+                c->victim = (g_max_age_s > 0 && !c->newest && now - v->created_ms > g_max_age_s * 1000ULL) ||
+                            (g_quarantine_age_s > 0 && v->quarantined &&
+                             now - v->created_ms > g_quarantine_age_s * 1000ULL);
+            }
+            // 실행 시작 버전의 점수를 같은 파일의 뒤 버전들 점수 이상으로 (최근에 복구에 쓴 뒤 버전보다도 늦게 지움)
+            int64_t later = INT64_MIN;
+            for (size_t k = n; k-- > first;) {
+                if (cand[k].run_start && !cand[k].newest && cand[k].score < later) {
+                    cand[k].score = later;
+                }
+                if (cand[k].score > later) {
+                    later = cand[k].score;
+                }
+            }
+        }
+    }
+
+    uint64_t remaining = g_total_bytes;
+    for (size_t i = 0; i < n; i++) {
+        if (cand[i].victim) {
+            remaining -= cand[i].size;
+        }
+    }
+    if (g_quota > 0 && remaining > g_quota) {
+        uint64_t low = g_quota / 100 * EVICT_LOW_PERCENT;
+        qsort(cand, n, sizeof(EvictCandidate), candidate_cmp);
+        for (size_t i = 0; i < n && remaining > low; i++) {
+            if (!cand[i].victim) {
+                cand[i].victim = 1;
+                remaining -= cand[i].size;
+            }
+        }
+    }
+
+    size_t count = 0;
+    Victim *victims = malloc(n * sizeof(Victim));
+    for (size_t i = 0; victims != NULL && i < n; i++) {
+        if (cand[i].victim) {
+            victims[count].key = cand[i].vf->key;
+            victims[count].created_ms = cand[i].created_ms;
+            victims[count].pid = cand[i].pid;
+            victims[count].quarantined = cand[i].quarantined;
+            version_remove(cand[i].vf, cand[i].created_ms);
+            count++;
+        }
+    }
+    free(cand);
+    *out = victims;
+    return count;
+}
+
+// 정리 스레드: 한도를 넘었다는 신호 또는 주기마다 깨어나 정리
+static void *evict_thread(void *arg) {
+    (void) arg;
+    size_t count = 0;
+    int first = 1; // 시작하자마자 한 번 (꺼져 있던 동안 기간이 지난 버전/격리본)
+    // 격리 기간이 주기보다 짧으면 그 간격으로 검사
+    unsigned interval = g_quarantine_age_s > 0 && g_quarantine_age_s < EVICT_INTERVAL_S
+                            ? g_quarantine_age_s : EVICT_INTERVAL_S;
+    pthread_mutex_lock(&g_lock);
+    for (;;) {
+        // 방금 정리했는데도 한도를 넘으면 (그 사이 백업이 더 들어옴) 기다리지 않고 한 번 더
+        if (!first && (count == 0 || !(g_quota > 0 && g_total_bytes > g_quota))) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_sec += interval;
+            pthread_cond_timedwait(&g_cond, &g_lock, &deadline);
+        }
+        first = 0;
+
+        Victim *victims;
+        count = evict_select(&victims);
+        if (count == 0) {
+            free(victims);
+            continue;
+        }
+        g_evicted += count;
+        uint64_t total = g_total_bytes;
+        pthread_mutex_unlock(&g_lock);
+
+        char path[PATH_MAX];
+        for (size_t i = 0; i < count; i++) {
+            version_path(path, victims[i].key, victims[i].created_ms, victims[i].pid, victims[i].quarantined);
+            unlink(path);
+        }
+        free(victims);
+        fprintf(stderr, "VERSIONS: 버전 %zu개 정리, 남은 크기 %llu 바이트 (한도 %llu)\n", count,
+                (unsigned long long)total, (unsigned long long)g_quota);
+
+        pthread_mutex_lock(&g_lock);
+    }
+    return NULL;
+}
+
+// 파일 하나의 버전 디렉터리 읽기 (시작 시)
+static void load_file_dir(const char *name) {
+    char dir[PATH_MAX], path[PATH_MAX], relpath[PATH_MAX];
+    unsigned long long key;
+    if (sscanf(name, "%16llx", &key) != 1 || strlen(name) != 16) {
+        return;
+    }
+    snprintf(dir, sizeof(dir), "%s/%.16s", g_dir, name);
+    snprintf(path, sizeof(path), "%s/%.16s/path", g_dir, name);
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return;
+    }
+    ssize_t n = read(fd, relpath, sizeof(relpath) - 1);
+    close(fd);
+    if (n <= 0) {
+        return;
+    }
+    relpath[n] = '\0';
+
+    DIR *dp = opendir(dir);
+    if (dp == NULL) {
+        return;
+    }
+    VersionFile *vf = file_add(key, relpath);
+    struct dirent *de;
+    while (vf != NULL && (de = readdir(dp)) != NULL) {
+        unsigned long long created;
+        int pid, end = 0;
+        if (sscanf(de->d_name, "%llu-%d%n", &created, &pid, &end) != 2) {
+            continue;
+        }
+        struct stat st;
+        int quarantined = strcmp(de->d_name + end, "-q") == 0;
+        if ((de->d_name[end] != '\0' && !quarantined) || fstatat(dirfd(dp), de->d_name, &st, 0) == -1) {
+            unlinkat(dirfd(dp), de->d_name, 0); // 중간에 끊긴 버전 (.part)
+            continue;
+        }
+        Version v = { .created_ms = created, .used_ms = created, .size = (uint64_t)st.st_size, .pid = pid,
+                      .quarantined = quarantined };
+        version_add(vf, &v);
+    }
+    closedir(dp);
+}
+
+int versions_init(const char *backup_dir, uint64_t quota_bytes, unsigned max_age_s, unsigned quarantine_age_s) {
+    if (snprintf(g_dir, sizeof(g_dir), "%s/versions", backup_dir) >= (int)sizeof(g_dir)) {
+        fprintf(stderr, "VERSIONS: 경로가 너무 김: %s\n", backup_dir);
+        return -1;
+    }
+    if (mkdir(g_dir, 0700) == -1 && errno != EEXIST) {
+        perror("VERSIONS: 디렉터리 생성 실패");
+        return -1;
+    }
+    g_quota = quota_bytes;
+    g_max_age_s = max_age_s;
+    g_quarantine_age_s = quarantine_age_s;
+
+    pthread_mutex_lock(&g_lock);
+    if (buckets_grow() != 0) {
+        pthread_mutex_unlock(&g_lock);
+        return -1;
+    }
+    DIR *dp = opendir(g_dir);
+    if (dp != NULL) {
+        struct dirent *de;
+        while ((de = readdir(dp)) != NULL) {
+            if (de->d_name[0] != '.') {
+                load_file_dir(de->d_name);
+            }
+        }
+        closedir(dp);
+    }
+    fprintf(stderr, "VERSIONS: 파일 %zu개, 버전 %llu개 (%llu 바이트) 로드, 한도 %llu 바이트, 보관 %u초\n",
+            g_file_count, (unsigned long long)g_version_count, (unsigned long long)g_total_bytes,
+            (unsigned long long)g_quota, g_max_age_s);
+    pthread_mutex_unlock(&g_lock);
+    return 0;
+}
+
+int versions_start_evictor(void) {
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, evict_thread, NULL) != 0) {
+        fprintf(stderr, "VERSIONS: 정리 스레드 생성 실패 (한도 적용 안 됨)\n");
+        return -1;
+    }
+    pthread_detach(thread);
+    return 0;
+}
+
+// 새 버전 이름(시각) 예약 + 파일 디렉터리 준비
+static int version_reserve(const char *relpath, uint64_t *key_out, uint64_t *created_out) {
+    uint64_t key = path_key(relpath);
+    char dir[PATH_MAX];
+    file_dir(dir, key);
+
+    pthread_mutex_lock(&g_lock);
+    VersionFile *vf = file_find(key);
+    if (vf != NULL && strcmp(vf->relpath, relpath) != 0) {
+        pthread_mutex_unlock(&g_lock);
+        fprintf(stderr, "VERSIONS: 경로 해시 충돌: %s / %s\n", relpath, vf->relpath);
+        return -1;
+    }
+    int is_new = vf == NULL;
+    if (is_new && (vf = file_add(key, relpath)) == NULL) {
+        pthread_mutex_unlock(&g_lock);
+        return -1;
+    }
+    uint64_t now = now_ms();
+    *created_out = now > vf->next_ms ? now : vf->next_ms;
+    vf->next_ms = *created_out + 1;
+    pthread_mutex_unlock(&g_lock);
+
+    if (mkdir(dir, 0700) == -1 && errno != EEXIST) {
+        return -1;
+    }
+    if (is_new) {
+        // 원래 경로 기록 (시작할 때 목록 복원용)
+        char path[PATH_MAX];
+        snprintf(path, sizeof(path), "%s/%016llx/path", g_dir, (unsigned long long)key);
+        int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+        if (fd == -1 || write(fd, relpath, strlen(relpath)) != (ssize_t)strlen(relpath)) {
+            if (fd != -1) {
+                close(fd);
+            }
+            return -1;
+        }
+        close(fd);
+    }
+    *key_out = key;
+    return 0;
+}
+
+// 목록에 추가 (한도 넘으면 정리 스레드 깨움, 정리는 스레드에서 -> write 경로는 기다리지 않음)
+static int version_publish(uint64_t key, const Version *v) {
+    pthread_mutex_lock(&g_lock);
+    VersionFile *vf = file_find(key);
+    int ret = vf != NULL ? version_add(vf, v) : -1;
+    if (g_quota > 0 && g_total_bytes > g_quota) {
+        pthread_cond_signal(&g_cond);
+    }
+    pthread_mutex_unlock(&g_lock);
+    return ret;
+}
+
+int versions_begin(const char *relpath, pid_t pid, VersionTicket *t) {
+    if (version_reserve(relpath, &t->key, &t->created_ms) != 0) {
+        return -1;
+    }
+    t->pid = pid;
+    version_path(t->tmp_path, t->key, t->created_ms, pid, 0);
+    strncat(t->tmp_path, ".part", sizeof(t->tmp_path) - strlen(t->tmp_path) - 1);
+    t->fd = open(t->tmp_path, O_WRONLY | O_CREAT | O_EXCL, 0600);
+    return t->fd == -1 ? -1 : 0;
+}
+
+int versions_commit(VersionTicket *t, int ok) {
+    struct stat st;
+    char path[PATH_MAX];
+    version_path(path, t->key, t->created_ms, t->pid, 0);
+    if (ok && (fstat(t->fd, &st) == -1 || rename(t->tmp_path, path) == -1)) {
+        ok = 0;
+    }
+    close(t->fd);
+    t->fd = -1;
+    if (!ok) {
+        unlink(t->tmp_path);
+        return -1;
+    }
+
+    Version v = { .created_ms = t->created_ms, .used_ms = now_ms(), .size = (uint64_t)st.st_size, .pid = t->pid };
+    return version_publish(t->key, &v);
+}
+
+// reflink 로 같은 내용의 새 파일 (데이터 블록 공유, 같은 파일시스템이 아니거나 지원 안 하면 실패)
+static int clone_to(int dirfd, const char *relpath, const char *dest) {
+    int src = openat(dirfd, relpath, O_RDONLY | O_NOFOLLOW);
+    if (src == -1) {
+        return -1;
+    }
+    int dst = open(dest, O_WRONLY | O_CREAT | O_EXCL, 0600);
+    int ret = -1;
+#ifdef FICLONE
+    if (dst != -1) {
+        ret = ioctl(dst, FICLONE, src);
+    }
+#endif
+    if (dst != -1) {
+        close(dst);
+        if (ret != 0) {
+            unlink(dest);
+        }
+    }
+    close(src);
+    return ret == 0 ? 0 : -1;
+}
+
+int versions_quarantine(int dirfd, const char *relpath, pid_t pid, int move, uint64_t *created_out) {
+    struct stat st;
+    if (fstatat(dirfd, relpath, &st, AT_SYMLINK_NOFOLLOW) == -1 || !S_ISREG(st.st_mode)) {
+        return -1;
+    }
+    uint64_t key, created;
+    if (version_reserve(relpath, &key, &created) != 0) {
+        return -1;
+    }
+    char path[PATH_MAX];
+    version_path(path, key, created, pid, 1);
+
+    // 이름만 옮기거나 하나 더 붙임 (파일 크기와 무관하게 메타데이터 연산 하나)
+    int ok = move ? renameat(dirfd, relpath, AT_FDCWD, path) == 0 : linkat(dirfd, relpath, AT_FDCWD, path, 0) == 0;
+    if (!ok && clone_to(dirfd, relpath, path) == 0) {
+        ok = 1;
+        if (move && unlinkat(dirfd, relpath, 0) == -1) {
+            int saved = errno;
+            unlink(path);
+            errno = saved;
+            return -1;
+        }
+    }
+    if (!ok) {
+        return -1;
+    }
+    Version v = { .created_ms = created, .used_ms = now_ms(), .size = (uint64_t)st.st_size, .pid = pid,
+                  .quarantined = 1 };
+    version_publish(key, &v);
+    if (created_out != NULL) {
+        *created_out = created;
+    }
+    return 0;
+}
+
+void versions_unquarantine(const char *relpath, pid_t pid, uint64_t created) {
+    uint64_t key = path_key(relpath);
+    pthread_mutex_lock(&g_lock);
+    VersionFile *vf = file_find(key);
+    if (vf != NULL) {
+        version_remove(vf, created);
+    }
+    pthread_mutex_unlock(&g_lock);
+    char path[PATH_MAX];
+    version_path(path, key, created, pid, 1);
+    unlink(path);
+}
+
+static size_t version_pick(const VersionFile *vf, pid_t pid) {
+    size_t i = vf->count - 1;
+    if (pid > 0) {
+        size_t j = vf->count;
+        while (j > 0 && vf->v[j - 1].pid != pid) {
+            j--;
+        }
+        if (j > 0) {
+            for (i = j - 1; i > 0 && vf->v[i - 1].pid == pid; i--) {
+            }
+        }
+    }
+    return i;
+}
+
+int versions_open(const char *relpath, pid_t pid) {
+    uint64_t key = path_key(relpath);
+    int fd = -1;
+    pthread_mutex_lock(&g_lock);
+    VersionFile *vf = file_find(key);
+    if (vf != NULL && vf->count > 0 && strcmp(vf->relpath, relpath) == 0) {
+        // 락을 잡은 채로 열어서 정리 스레드가 그 사이에 지우지 못하게 함 (열린 뒤 지워져도 fd 는 유효)
+        Version *v = &vf->v[version_pick(vf, pid)];
+        char path[PATH_MAX];
+        version_path(path, key, v->created_ms, v->pid, v->quarantined);
+        fd = open(path, O_RDONLY);
+        if (fd != -1) {
+            v->used_ms = now_ms();
+        }
+    }
+    pthread_mutex_unlock(&g_lock);
+    return fd;
+}
+
+void versions_stats(uint64_t *count, uint64_t *bytes, uint64_t *evicted) {
+    pthread_mutex_lock(&g_lock);
+    if (count) {
+        *count = g_version_count;
+    }
+    if (bytes) {
+        *bytes = g_total_bytes;
+    }
+    if (evicted) {
+        *evicted = g_evicted;
+    }
+    pthread_mutex_unlock(&g_lock);
+}
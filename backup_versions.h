@@ -0,0 +1,54 @@
+#ifndef BACKUP_VERSIONS_H
+#define BACKUP_VERSIONS_H
+
+#include <stdint.h>
+#include <limits.h>
+#include <sys/types.h>
+
+/* 버전별 백업 저장소 (처음 한 번만 백업하던 것 대신, 쓰기 세션마다 새 버전)
+ - <백업dir>/versions/<경로 해시 16자리>/path       : 원래 상대 경로
+ - <백업dir>/versions/<경로 해시 16자리>/<ms>-<pid>  : 그 시각 쓰기 직전 내용 (만든 프로세스 pid)
+ - <백업dir>/versions/<경로 해시 16자리>/<ms>-<pid>-q: 삭제/덮어쓰기된 파일 자체 (복사 없이 rename/link 로 격리)
+ - 목록은 메모리에 두고 시작할 때 디렉터리를 읽어 다시 만듦
+ - 정리 스레드가 용량 한도/보관 기간을 지킴 (write 경로는 기다리지 않음):
+   오래 안 쓴 버전부터 (큰 버전은 더 오래된 것으로 취급), 파일마다 최신 버전은 마지막까지 남김
+   pid 마다 쓰기 직전 버전 (연달아 만든 것 중 첫 번째) 은 그 뒤 버전들보다 늦게 지움 */
+
+typedef struct {
+    int fd;                     // 새 버전 내용을 쓸 fd (versions_commit 이 닫음)
+    uint64_t key;
+    uint64_t created_ms;
+    pid_t pid;
+    char tmp_path[PATH_MAX];    // 다 쓰기 전 이름 (.part, 시작할 때 남아 있으면 삭제)
+} VersionTicket;
+
+/* 저장소 열기 (목록 로드, 스레드는 만들지 않음)
+ - quota_bytes: 전체 버전 크기 한도 (0 = 무제한), max_age_s: 보관 기간 (0 = 무제한)
+ - quarantine_age_s: 격리본 보관 기간 (최신 버전이어도 지움, 0 = 무제한) */
+int versions_init(const char *backup_dir, uint64_t quota_bytes, unsigned max_age_s, unsigned quarantine_age_s);
+// 정리 스레드 시작 (데몬화 뒤에 호출: fork 전에 만든 스레드는 자식 프로세스에 없음)
+int versions_start_evictor(void);
+
+// relpath 의 새 버전 시작 (pid: 쓰려는 프로세스), 반환: 0 = t->fd 에 내용을 쓰면 됨, -1 = 실패
+int versions_begin(const char *relpath, pid_t pid, VersionTicket *t);
+// ok 이면 버전 확정 (목록에 추가, 한도 넘으면 정리 스레드 깨움), 아니면 임시 파일 삭제
+int versions_commit(VersionTicket *t, int ok);
+
+/* dirfd 기준 relpath 의 일반 파일을 복사 없이 버전으로 격리 (백업 디렉터리가 같은 파일시스템일 때)
+ - move = 1 (unlink 대신): renameat 으로 옮김 -> 원래 이름은 없어짐
+ - move = 0 (rename 으로 덮어쓰일 목적지): linkat 으로 이름 하나 더 -> 원래 이름은 그대로
+ - 다른 파일시스템이면 reflink 로 (move 면 그 뒤 unlink), 그것도 안 되면 -1 (원래 파일은 그대로)
+ - 반환: 0 = 격리됨, -1 = 격리 못 함 (일반 파일 아님, 없음 등) */
+int versions_quarantine(int dirfd, const char *relpath, pid_t pid, int move, uint64_t *created_out);
+// 격리 되돌리기 (rename 이 실패해서 목적지가 그대로일 때): created 는 versions_quarantine 이 준 값
+void versions_unquarantine(const char *relpath, pid_t pid, uint64_t created);
+
+/* 복구에 쓸 버전을 읽기 전용으로 열기 (없으면 -1)
+ - pid > 0: 그 프로세스가 마지막으로 연달아 만든 버전들 중 가장 이른 것 (= 처음 쓰기 직전 내용)
+   그 프로세스가 만든 버전이 없으면 (또는 pid <= 0) 최신 버전 */
+int versions_open(const char *relpath, pid_t pid);
+
+// 버전 수, 전체 크기, 정리된 버전 수
+void versions_stats(uint64_t *count, uint64_t *bytes, uint64_t *evicted);
+
+#endif
@@ -1,5 +1,4 @@
 #define FUSE_USE_VERSION 35
-#define MAX_TRACKED_PIDS 100
 #include <fuse3/fuse.h>
 #include <stdio.h>
 #include <stdlib.h>     // realpath 함수 사용을 위해 추가
@@ -13,13 +12,113 @@
 #include <sys/time.h>
 #include <signal.h>
 #include <sys/types.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/ioctl.h>
 #include "restore.h" //[RESTORE]
+#include "score_table.h"
 #include "analyzer.h" // (재린 추가함) 스코어 계산하는 함수
+#include "entropy.h"
+#include "pipeline.h"
+#include "backend_io.h"
+#include "undo_journal.h"
+#include "rollback.h"
 #define KILL_THRESHOLD 80    // Malice Score 강제 종료 임계값 ((임시))
 
 //이은지 추가 부분 : [RESTORE] 검색
 
 static int base_fd = -1;
+static int g_writeback = 0; // init 에서 writeback 캐시가 실제로 켜졌는지
+
+#define MYFS_MAX_WRITE (1024 * 1024) // write 요청 하나의 최대 크기 (1MB = 256 페이지)
+
+// 마운트 옵션 (-o entropy_sample,entropy_sample_blocks=16 ...)
+struct myfs_config {
+    int entropy_sample;             // 큰 write 는 블록 표본으로 엔트로피 추정
+    int entropy_sample_random;      // 표본 위치 무작위 선택
+    unsigned long sample_blocks;    // 표본 블록 개수 (0 = 기본값)
+    unsigned long sample_block_size;// 표본 블록 크기 (0 = 기본값)
+    int async_analyzer;             // 점수 계산을 분석 워커 스레드로 넘김 (기본: 동기)
+    unsigned analyzer_threads;      // 분석 워커 수
+    unsigned analyzer_queue;        // 워커당 링 크기
+    unsigned score_half_life;       // 점수 반감기 (초, 0 = 감쇠 없음)
+    int splice_read;                // read 를 백엔드 fd 에서 /dev/fuse 로 바로 splice (기본: 켬)
+    int passthrough;                // 읽기 전용 open 은 커널이 백엔드 파일에서 직접 읽음 (기본: 켬, 지원 시)
+    double attr_timeout;            // 커널이 속성(getattr 결과)을 캐시하는 시간 (초)
+    double entry_timeout;           // 커널이 이름 -> inode 조회 결과를 캐시하는 시간 (초)
+    double negative_timeout;        // 없는 이름 조회 결과를 캐시하는 시간 (초)
+    int writeback_cache;            // 커널 writeback 캐시: 작은 write 를 모아서 큰 덩어리로 보냄 (기본: 끔)
+    int uring;                      // 백엔드 read/write/fsync, 백업 복사를 io_uring 으로 (기본: 끔, HAVE_LIBURING 빌드)
+    unsigned uring_depth;           // 스레드별 링 크기
+    int undo_journal;               // 첫 write 때 파일 전체 대신 덮어쓸 범위만 저널에 백업 (기본: 끔)
+    int dedup_backup;               // 백업을 내용 기반 청크 저장소에 (중복 청크는 한 번만, 기본: 끔)
+    int compress_backup;            // 복사 백업본을 lz4/zstd 로 압축 (엔트로피 높은 파일은 제외, 기본: 끔)
+    unsigned rollback_threads;      // kill 시 수정된 파일을 병렬 복구하는 워커 수 (0 = CPU 수)
+    int versioned_backup;           // 쓰기 세션마다 새 백업 버전 (기본: 끔, 처음 한 번만)
+    unsigned long backup_quota_mb;  // 버전 백업 전체 한도 (MB, 0 = 무제한)
+    unsigned backup_max_age;        // 버전 보관 기간 (초, 0 = 무제한, 파일마다 최신 버전은 남김)
+    int quarantine;                 // unlink/rename 으로 사라질 파일을 지우지 않고 격리 (기본: 끔)
+    unsigned quarantine_max_age;    // 격리본 보관 기간 (초, 0 = 무제한)
+    int backup_journal;             // 백업 상태 저널 (다 쓴 백업본만 남김, 시작 시 디렉터리 스캔 안 함, 기본: 켬)
+};
+static struct myfs_config g_config = {
+    .analyzer_threads = 2,
+    .analyzer_queue = 64,
+    .score_half_life = 30,
+    .splice_read = 1,
+    .passthrough = 1,
+    .attr_timeout = 5.0,
+    .entry_timeout = 5.0,
+    .negative_timeout = 1.0,
+    .uring_depth = 64,
+    .backup_quota_mb = 1024,
+    .backup_max_age = 7 * 24 * 3600,
+    .quarantine_max_age = 24 * 3600,
+    .backup_journal = 1,
+};
+
+#define MYFS_OPT(t, p, v) { t, offsetof(struct myfs_config, p), v }
+static const struct fuse_opt myfs_opts[] = {
+    MYFS_OPT("entropy_sample", entropy_sample, 1),
+    MYFS_OPT("entropy_sample_random", entropy_sample_random, 1),
+    MYFS_OPT("entropy_sample_blocks=%lu", sample_blocks, 0),
+    MYFS_OPT("entropy_sample_block_size=%lu", sample_block_size, 0),
+    MYFS_OPT("async_analyzer", async_analyzer, 1),
+    MYFS_OPT("analyzer_threads=%u", analyzer_threads, 0),
+    MYFS_OPT("analyzer_queue=%u", analyzer_queue, 0),
+    MYFS_OPT("score_half_life=%u", score_half_life, 0),
+    MYFS_OPT("splice_read", splice_read, 1),
+    MYFS_OPT("no_splice_read", splice_read, 0),
+    MYFS_OPT("passthrough", passthrough, 1),
+    MYFS_OPT("no_passthrough", passthrough, 0),
+    MYFS_OPT("attr_timeout=%lf", attr_timeout, 0),
+    MYFS_OPT("entry_timeout=%lf", entry_timeout, 0),
+    MYFS_OPT("negative_timeout=%lf", negative_timeout, 0),
+    MYFS_OPT("writeback_cache", writeback_cache, 1),
+    MYFS_OPT("no_writeback_cache", writeback_cache, 0),
+    MYFS_OPT("uring", uring, 1),
+    MYFS_OPT("no_uring", uring, 0),
+    MYFS_OPT("uring_depth=%u", uring_depth, 0),
+    MYFS_OPT("undo_journal", undo_journal, 1),
+    MYFS_OPT("no_undo_journal", undo_journal, 0),
+    MYFS_OPT("dedup_backup", dedup_backup, 1),
+    MYFS_OPT("no_dedup_backup", dedup_backup, 0),
+    MYFS_OPT("compress_backup", compress_backup, 1),
+    MYFS_OPT("no_compress_backup", compress_backup, 0),
+    MYFS_OPT("rollback_threads=%u", rollback_threads, 0),
+    MYFS_OPT("versioned_backup", versioned_backup, 1),
+    MYFS_OPT("no_versioned_backup", versioned_backup, 0),
+    MYFS_OPT("backup_quota_mb=%lu", backup_quota_mb, 0),
+    MYFS_OPT("backup_max_age=%u", backup_max_age, 0),
+    MYFS_OPT("quarantine", quarantine, 1),
+    MYFS_OPT("no_quarantine", quarantine, 0),
+    MYFS_OPT("quarantine_max_age=%u", quarantine_max_age, 0),
+    MYFS_OPT("backup_journal", backup_journal, 1),
+    MYFS_OPT("no_backup_journal", backup_journal, 0),
+    FUSE_OPT_END
+};
 
 // 블랙리스트 생성(해당 이름의 파일을 차단)
 static const char *blacklist[] = {
@@ -53,69 +152,360 @@ static int is_writable_whitelisted(const char *path) {
     return 0; // 쓰기 차단
 }
 
-// PID별 Malice Score, 행동 정보 저장할 구조체
+// 블랙리스트 파일은 실행 권한을 빼고 보여줌 (getattr, readdirplus 공통)
+static void mask_blacklisted(const char *path, struct stat *stbuf) {
+    if (S_ISREG(stbuf->st_mode) && (stbuf->st_mode & (S_IXUSR | S_IXGRP | S_IXOTH))) {
+        // 블랙리스트에 존재 여부 검사
+        if (is_blacklisted(path)) {
+            // 존재하면 실행에 대한 권한 강제 제거
+            stbuf->st_mode &= ~(S_IXUSR | S_IXGRP | S_IXOTH);
+        }
+    }
+}
+
+/* 파일별 마지막 open 시점의 mtime/크기 (inode 로 인덱싱하는 고정 크기 캐시)
+ 다시 열 때 그대로면 keep_cache 로 커널 페이지 캐시를 유지 -> 같은 파일 반복 읽기에서 재읽기 없음
+ 칸이 겹치면 덮어씀 (그 경우 캐시를 버리는 쪽이라 안전) */
+#define MTIME_CACHE_SIZE 1024
 typedef struct {
-    pid_t pid;             
-    int malice_score;      
-    time_t last_write_time; // 마지막 쓰기 연산 시간 
-    char proc_name[32];  //  프로세스 이름 저장
-} ProcessScore;
-
-// 전역 Score 테이블
-ProcessScore g_score_table[MAX_TRACKED_PIDS];
-int g_process_count = 0; // 현재 추적 중인 프로세스 개수
-
-// ProcessScore 엔트리를 찾거나 새로 생성해 포인터 반환
-ProcessScore* find_or_create_score_entry(pid_t pid) {
-    // 기존 엔트리 검색
-    for (int i = 0; i < g_process_count; i++) {
-        if (g_score_table[i].pid == pid) {
-            // PID가 이미 존재하면 해당 엔트리 반환
-            return &g_score_table[i];
-	}
+    dev_t dev;
+    ino_t ino;
+    struct timespec mtime;
+    off_t size;
+} MtimeEntry;
+static MtimeEntry mtime_cache[MTIME_CACHE_SIZE];
+static pthread_mutex_t mtime_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// 지난 open 이후 안 바뀌었으면 1, 이번 값을 기록
+static int mtime_unchanged(const struct stat *st) {
+    MtimeEntry *e = &mtime_cache[(st->st_ino ^ st->st_dev) % MTIME_CACHE_SIZE];
+    pthread_mutex_lock(&mtime_lock);
+    int same = e->ino == st->st_ino && e->dev == st->st_dev && e->size == st->st_size &&
+               e->mtime.tv_sec == st->st_mtim.tv_sec && e->mtime.tv_nsec == st->st_mtim.tv_nsec;
+    e->dev = st->st_dev;
+    e->ino = st->st_ino;
+    e->mtime = st->st_mtim;
+    e->size = st->st_size;
+    pthread_mutex_unlock(&mtime_lock);
+    return same;
+}
+
+// 열린 파일마다 fi->fh 에 달아두는 상태
+typedef struct {
+    int fd;                 // 백엔드 파일 디스크립터
+    pthread_mutex_t lock;   // 같은 핸들에 대한 동시 write 보호
+    WriteStream stream;     // 순차 write 누적 엔트로피
+    atomic_int refs;        // release + 아직 처리 안 된 분석 이벤트 수
+    pid_t owner;            // 연 프로세스 (writeback 캐시에서는 write 요청의 pid 가 커널 스레드일 수 있음)
+    int backing_id;         // 커널 passthrough 등록 번호 (0 = 안 씀)
+    int io_mode;            // io_modes 에 센 종류 (IO_MODE_*, 0 = 안 셈)
+    dev_t dev;              // io_mode 가 있을 때만 씀
+    ino_t ino;
+    UndoFile *undo;         // 되돌리기 저널 (undo_journal 모드의 쓰기 핸들만, 아니면 NULL)
+    BackupId id;            // 백업 색인 키 (쓰기 핸들만, open 때 한 번 구함)
+    int id_valid;
+    int backed_up;          // 이 핸들에서 백업본 확인됨 -> 이후 write 는 색인 조회도 생략
+    pid_t touched_by;       // 이 핸들로 쓴 프로세스의 수정 파일 집합에 이미 넣음 (-1 = 아직)
+} FileHandle;
+
+#define FH(fi) ((FileHandle *)(uintptr_t)(fi)->fh)
+
+// 분석 워커가 핸들을 쓰는 동안 release 되어도 메모리가 남아 있도록 참조 카운트 사용
+static void file_handle_put(FileHandle *fh) {
+    if (atomic_fetch_sub(&fh->refs, 1) == 1) {
+        pthread_mutex_destroy(&fh->lock);
+        free(fh);
     }
-    
-    // 새 엔트리 생성
-    if (g_process_count < MAX_TRACKED_PIDS) {
-        ProcessScore *new_entry = &g_score_table[g_process_count];
-        // 새로운 엔트리 초기화
-        new_entry->pid = pid;
-        new_entry->malice_score = 0;
-        new_entry->last_write_time = time(NULL);
-        g_process_count++; // 추적 중인 프로세스 수 증가
-        
-        return new_entry;
+}
+
+// 백엔드 fd 로 FileHandle 생성 후 fi->fh 에 연결
+static int attach_file_handle(struct fuse_file_info *fi, int fd) {
+    FileHandle *fh = malloc(sizeof(*fh));
+    if (fh == NULL) {
+        close(fd);
+        return -ENOMEM;
     }
-    
-    // 배열이 가득 찼을 때 
-    fprintf(stderr, "오류: 최대 PID 추적 개수 초과!\n");
-    return NULL;
+    fh->fd = fd;
+    fh->backing_id = 0;
+    fh->io_mode = 0;
+    fh->undo = NULL;
+    fh->backed_up = 0;
+    fh->touched_by = -1;
+    fh->id_valid = (fi->flags & O_ACCMODE) != O_RDONLY && restore_file_id(fd, &fh->id) == 0;
+    fh->owner = fuse_get_context()->pid;
+    atomic_init(&fh->refs, 1);
+    pthread_mutex_init(&fh->lock, NULL);
+    write_stream_init(&fh->stream);
+    fi->fh = (uint64_t)(uintptr_t)fh;
+    return 0;
 }
 
-// 특정 PID의 Malice Score 업데이트, 마지막 쓰기 시간 갱신
-void update_malice_score(pid_t pid, int added_score) {
-    ProcessScore *entry = find_or_create_score_entry(pid);
-    
-    if (entry) {
-        entry->malice_score += added_score;
-        entry->last_write_time = time(NULL); 
+// 저널 모드: relpath 가 파일의 마지막 이름인지 (지운 뒤 그 inode 의 저널도 undo_discard)
+static int undo_last_link(const char *relpath, struct stat *st) {
+    return g_config.undo_journal && fstatat(base_fd, relpath, st, AT_SYMLINK_NOFOLLOW) == 0 &&
+           S_ISREG(st->st_mode) && st->st_nlink == 1;
+}
+
+// 저널 모드: 쓰기 핸들에 파일의 저널 상태 연결 (실패하면 NULL -> 기존 전체 백업)
+static void attach_undo(struct fuse_file_info *fi, const char *relpath) {
+    if (g_config.undo_journal && (fi->flags & O_ACCMODE) != O_RDONLY) {
+        FH(fi)->undo = undo_open(base_fd, relpath);
+    }
+}
+
+/* 커널 FUSE passthrough (리눅스 6.9+, libfuse 3.16+)
+ 읽기 전용 open 의 백엔드 fd 를 /dev/fuse 에 등록해두면 커널이 read/mmap 을 데몬을 거치지 않고 처리함.
+ 분석기는 read 를 보지 않으므로 놓치는 것이 없고, write 는 계속 myfs_write 로 들어옴 */
+#ifdef FUSE_CAP_PASSTHROUGH
+#ifndef FUSE_DEV_IOC_BACKING_OPEN
+struct myfs_backing_map {
+    int32_t fd;
+    uint32_t flags;
+    uint64_t padding;
+};
+#define FUSE_DEV_IOC_BACKING_OPEN _IOW(229, 1, struct myfs_backing_map)
+#define FUSE_DEV_IOC_BACKING_CLOSE _IOW(229, 2, uint32_t)
+#define MYFS_BACKING_MAP struct myfs_backing_map
+#else
+#define MYFS_BACKING_MAP struct fuse_backing_map
+#endif
+
+static atomic_int g_passthrough = 0; // init 에서 커널 지원 확인 후 켬, 등록 실패하면 끔
+
+/* inode 별 열린 핸들 수
+ 커널은 같은 inode 에 passthrough open 과 캐시 open 이 섞이면 open 을 EIO 로 실패시킴
+ -> 쓰기 open 은 passthrough 읽기가 열려 있을 때만 direct_io, 읽기 open 은 캐시 쓰기가 열려 있으면 passthrough 안 씀 */
+#define IO_MODE_PASSTHROUGH 1
+#define IO_MODE_CACHED 2
+#define IO_MODE_BUCKETS 256
+typedef struct IoMode {
+    dev_t dev;
+    ino_t ino;
+    int readers;            // passthrough 읽기 핸들
+    int writers;            // 캐시 쓰기 핸들 (direct_io 아님)
+    struct IoMode *next;
+} IoMode;
+static IoMode *io_modes[IO_MODE_BUCKETS];
+static pthread_mutex_t io_mode_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// io_mode_lock 잡은 상태에서 호출, 없으면 만듦 (NULL = 메모리 부족)
+static IoMode *io_mode_get(dev_t dev, ino_t ino) {
+    IoMode **head = &io_modes[(ino ^ dev) % IO_MODE_BUCKETS];
+    for (IoMode *m = *head; m != NULL; m = m->next) {
+        if (m->ino == ino && m->dev == dev) {
+            return m;
+        }
+    }
+    IoMode *m = calloc(1, sizeof(*m));
+    if (m != NULL) {
+        m->dev = dev;
+        m->ino = ino;
+        m->next = *head;
+        *head = m;
+    }
+    return m;
+}
+
+// io_mode_lock 잡은 상태에서 호출, 센 핸들이 없으면 지움
+static void io_mode_drop_unused(IoMode *m) {
+    if (m == NULL || m->readers > 0 || m->writers > 0) {
+        return;
+    }
+    IoMode **pp = &io_modes[(m->ino ^ m->dev) % IO_MODE_BUCKETS];
+    while (*pp != m) {
+        pp = &(*pp)->next;
+    }
+    *pp = m->next;
+    free(m);
+}
+
+static int dev_fuse_fd(void) {
+    return fuse_session_fd(fuse_get_session(fuse_get_context()->fuse));
+}
+
+// 읽기 전용 핸들을 커널에 등록 (실패하면 그냥 pread/splice 경로 사용)
+static void passthrough_open(struct fuse_file_info *fi) {
+    if (!atomic_load_explicit(&g_passthrough, memory_order_relaxed)) {
+        return;
+    }
+    FileHandle *fh = FH(fi);
+    struct stat st;
+    if (fstat(fh->fd, &st) != 0) {
+        return;
+    }
+    pthread_mutex_lock(&io_mode_lock);
+    IoMode *m = io_mode_get(st.st_dev, st.st_ino);
+    if (m == NULL || m->writers > 0) {
+        io_mode_drop_unused(m); // 캐시 쓰기가 열려 있음 -> 이번 핸들은 데몬 read 경로
+        pthread_mutex_unlock(&io_mode_lock);
+        return;
+    }
+    MYFS_BACKING_MAP map = { .fd = fh->fd };
+    int id = ioctl(dev_fuse_fd(), FUSE_DEV_IOC_BACKING_OPEN, &map);
+    if (id <= 0) {
+        io_mode_drop_unused(m);
+        pthread_mutex_unlock(&io_mode_lock);
+        // 보통 CAP_SYS_ADMIN 이 없어서 EPERM -> 매번 실패하지 않도록 끔
+        fprintf(stderr, "INFO: FUSE passthrough 등록 실패 (%s), 데몬 read 경로 사용\n", strerror(errno));
+        atomic_store(&g_passthrough, 0);
+        return;
+    }
+    m->readers++;
+    pthread_mutex_unlock(&io_mode_lock);
+    fh->io_mode = IO_MODE_PASSTHROUGH;
+    fh->dev = st.st_dev;
+    fh->ino = st.st_ino;
+    fh->backing_id = id;
+    fi->backing_id = id;
+    fi->keep_cache = 0;
+}
+
+static void passthrough_close(FileHandle *fh) {
+    if (fh->backing_id > 0) {
+        uint32_t id = (uint32_t)fh->backing_id;
+        ioctl(dev_fuse_fd(), FUSE_DEV_IOC_BACKING_CLOSE, &id);
+        fh->backing_id = 0;
+    }
+    if (fh->io_mode != 0) {
+        pthread_mutex_lock(&io_mode_lock);
+        IoMode *m = io_mode_get(fh->dev, fh->ino);
+        if (m != NULL) {
+            if (fh->io_mode == IO_MODE_PASSTHROUGH) {
+                m->readers--;
+            } else {
+                m->writers--;
+            }
+            io_mode_drop_unused(m);
+        }
+        pthread_mutex_unlock(&io_mode_lock);
+        fh->io_mode = 0;
+    }
+}
+
+/* 쓰기 open: 같은 inode 에 passthrough 읽기가 열려 있을 때만 direct_io (쓰기는 어차피 데몬 경유)
+ 아니면 캐시 open 으로 두고 세어서, 닫을 때까지 같은 inode 의 읽기 open 은 passthrough 안 씀 */
+static void passthrough_write_open(struct fuse_file_info *fi) {
+    if (!atomic_load_explicit(&g_passthrough, memory_order_relaxed)) {
+        return;
+    }
+    FileHandle *fh = FH(fi);
+    struct stat st;
+    if (fstat(fh->fd, &st) != 0) {
+        fi->direct_io = 1; // 모르면 충돌 안 나는 쪽
+        return;
+    }
+    pthread_mutex_lock(&io_mode_lock);
+    IoMode *m = io_mode_get(st.st_dev, st.st_ino);
+    if (m == NULL || m->readers > 0) {
+        io_mode_drop_unused(m);
+        fi->direct_io = 1;
+    } else {
+        m->writers++;
+        fh->io_mode = IO_MODE_CACHED;
+        fh->dev = st.st_dev;
+        fh->ino = st.st_ino;
+    }
+    pthread_mutex_unlock(&io_mode_lock);
+}
+#else
+static void passthrough_open(struct fuse_file_info *fi) { (void) fi; }
+static void passthrough_close(FileHandle *fh) { (void) fh; }
+static void passthrough_write_open(struct fuse_file_info *fi) { (void) fi; }
+#endif
+
+// 핸들 정리 (release, 또는 release 가 오지 않는 실패한 create)
+static void release_file_handle(FileHandle *fh) {
+    passthrough_close(fh);
+    undo_close(fh->undo);
+    close(fh->fd);
+    file_handle_put(fh);
+}
+
+/* writeback 캐시 사용 시 open 플래그 보정
+ - 커널이 부분 페이지를 채우려고 O_WRONLY 파일도 read 함 -> O_RDWR 로 엶
+ - 덧붙이기 위치는 커널이 offset 으로 정해서 보냄 -> O_APPEND 를 남기면 pwrite 가 끝에 또 붙임 */
+static int backend_open_flags(int flags) {
+    if (g_writeback) {
+        if ((flags & O_ACCMODE) == O_WRONLY) {
+            flags = (flags & ~O_ACCMODE) | O_RDWR;
+        }
+        flags &= ~O_APPEND;
+    }
+    return flags;
+}
+
+//[RESTORE] 파일 하나 복구 (롤백 워커에서 호출)
+// 저널 모드면 저장한 범위만 되돌리고, 저널이 없으면 전체 백업본으로
+// 버전 모드면 그 프로세스가 처음 쓰기 직전 버전으로
+static int rollback_path(const char *path, pid_t pid) {
+    if (g_config.undo_journal && undo_rollback(base_fd, path[1] ? path + 1 : ".") == 0) {
+        return 0;
     }
+    return restore_backup_file_for(path, base_fd, pid);
 }
 
-// 특정 PID의 Malice Score 반환
-int get_malice_score(pid_t pid) {
-    ProcessScore *entry = find_or_create_score_entry(pid);
-    if (entry) {
-        return entry->malice_score;
+// 임계값 넘은 프로세스: 강제 종료 후 그 프로세스가 수정한 파일 전체 복구
+static void kill_and_restore(pid_t pid, const char *path, const char *op) {
+    fprintf(stderr, "Kill ! '%s' 임계값 초과! PID %d 강제 종료\n", op, pid);
+
+    if (pid <= 0) {
+        rollback_submit(pid, NULL, path); // 커널이 보낸 요청 (kill(0) 은 우리 프로세스 그룹 전체를 죽임)
+        return;
+    }
+
+    // 먼저 종료 (복구하는 동안 다른 파일을 계속 암호화하지 못하게)
+    if (kill(pid, SIGKILL) == -1) {
+        fprintf(stderr, "킬 명령어 실패: %s\n", strerror(errno));
     }
-    return 0; // 엔트리 못 찾으면 0점 반환
+
+    //[RESTORE] 이번 요청 경로 + 지금까지 수정한 파일 전부를 워커들이 나눠서 복구
+    rollback_submit(pid, score_table_take_touched(pid), path);
 }
 
-// 프로세스 종료 시 Score 0으로 초기화
-void reset_malice_score(pid_t pid) {
-    ProcessScore *entry = find_or_create_score_entry(pid);
-    if (entry) {
-        entry->malice_score = 0;
+// 분석 워커가 이미 kill 판정을 내린 프로세스인지 (비동기 모드에서 다음 연산 차단용)
+static int is_kill_pending(pid_t pid) {
+    ProcessScore *entry = score_table_acquire(pid, 0);
+    if (entry == NULL) {
+        return 0;
+    }
+    int pending = entry->kill_pending;
+    score_table_release(entry);
+    return pending;
+}
+
+// 분석 워커에서 실행: 점수 계산, 프로세스 상태 갱신, kill/복구 판단
+static void myfs_handle_event(const PipelineEvent *ev) {
+    static const char *op_names[] = { "write", "unlink", "rename" };
+    int added_score;
+    AnalyzerEvent aev = {
+        .op = (AnalyzerOp)ev->op, .pid = ev->pid,
+        .offset = ev->offset, .size = ev->data_len, .total_size = ev->size, .buf = ev->data,
+    };
+
+    if (ev->op == PIPE_OP_WRITE) {
+        FileHandle *fh = ev->ctx;
+        aev.stream = &fh->stream;
+        pthread_mutex_lock(&fh->lock);
+        added_score = get_event_score(&aev); // 표본만 복사했어도 점수/다음 위치는 원래 크기 기준
+        pthread_mutex_unlock(&fh->lock);
+        file_handle_put(fh);
+    } else {
+        added_score = get_event_score(&aev);
+    }
+
+    // 점수/빈도 갱신과 kill 판정을 엔트리 하나 잠근 상태에서 처리 (kill 은 한 번만)
+    int do_kill = 0;
+    ProcessScore *entry = score_table_acquire(ev->pid, 1);
+    if (entry != NULL) {
+        int score = analyzer_apply(entry, ev->op, added_score, ev->time_ms);
+        if (!entry->kill_pending && score >= KILL_THRESHOLD) {
+            entry->kill_pending = 1;
+            do_kill = 1;
+        }
+        score_table_release(entry);
+    }
+    if (do_kill) {
+        kill_and_restore(ev->pid, ev->path, op_names[ev->op]);
     }
 }
 
@@ -142,52 +532,98 @@ static int myfs_getattr(const char *path, struct stat *stbuf,
         return -errno;
     
     // 블랙리스트 기반 차단
-    if ((stbuf->st_mode & S_IFREG) && (stbuf->st_mode & (S_IXUSR | S_IXGRP | S_IXOTH))) {
-        // 블랙리스트에 존재 여부 검사
-        if (is_blacklisted(path)) {
-            // 존재하면 실행에 대한 권한 강제 제거
-            stbuf->st_mode &= ~(S_IXUSR | S_IXGRP | S_IXOTH);
-        }
-    }
-
+    mask_blacklisted(path, stbuf);
     return 0;
 }
 
-// readdir 함수 구현
-static int myfs_readdir(const char *path, void *buf, fuse_fill_dir_t filler,
-                        off_t offset, struct fuse_file_info *fi,
-                        enum fuse_readdir_flags flags) {
+// 열린 디렉터리마다 fi->fh 에 달아두는 상태 (readdir 이 여러 번 나눠 호출되어도 이어서 읽음)
+typedef struct {
     DIR *dp;
-    struct dirent *de;
-    int fd;
+    off_t offset;           // dp 가 현재 가리키는 위치 (telldir 값)
+    struct dirent *entry;   // 지난번 filler 가 가득 차서 못 넣은 항목 (다음 호출에서 먼저 넣음)
+} DirHandle;
 
-    (void) offset;
-    (void) fi;
-    (void) flags;
+#define DH(fi) ((DirHandle *)(uintptr_t)(fi)->fh)
 
+// opendir 함수 구현
+static int myfs_opendir(const char *path, struct fuse_file_info *fi) {
     char relpath[PATH_MAX];
     get_relative_path(path, relpath);
 
-    fd = openat(base_fd, relpath, O_RDONLY | O_DIRECTORY);
-    if (fd == -1)
-        return -errno;
+    DirHandle *d = malloc(sizeof(*d));
+    if (d == NULL)
+        return -ENOMEM;
 
-    dp = fdopendir(fd);
-    if (dp == NULL) {
+    int fd = openat(base_fd, relpath, O_RDONLY | O_DIRECTORY);
+    if (fd == -1) {
+        int err = errno;
+        free(d);
+        return -err;
+    }
+    d->dp = fdopendir(fd);
+    if (d->dp == NULL) {
+        int err = errno;
         close(fd);
-        return -errno;
+        free(d);
+        return -err;
     }
+    d->offset = 0;
+    d->entry = NULL;
+    fi->fh = (uint64_t)(uintptr_t)d;
+    return 0;
+}
 
-    while ((de = readdir(dp)) != NULL) {
+/* readdir 함수 구현
+ - 항목마다 telldir 값을 offset 으로 넘겨서 커널 버퍼가 차면 그 위치부터 다시 요청하게 함
+ - 요청 offset 이 핸들 위치와 같으면 그대로 이어서 읽고, 다르면 seekdir (처음부터 다시 읽지 않음) */
+static int myfs_readdir(const char *path, void *buf, fuse_fill_dir_t filler,
+                        off_t offset, struct fuse_file_info *fi,
+                        enum fuse_readdir_flags flags) {
+    DirHandle *d = DH(fi);
+    int plus = (flags & FUSE_READDIR_PLUS) != 0;
+
+    if (offset != d->offset) {
+        seekdir(d->dp, offset);
+        d->entry = NULL;
+        d->offset = offset;
+    }
+
+    for (;;) {
+        if (d->entry == NULL) {
+            d->entry = readdir(d->dp);
+            if (d->entry == NULL)
+                break;
+        }
+        struct dirent *de = d->entry;
+        off_t next = telldir(d->dp);
         struct stat st;
-        memset(&st, 0, sizeof(st));
-        st.st_ino = de->d_ino;
-        st.st_mode = de->d_type << 12;
-        if (filler(buf, de->d_name, &st, 0, 0))
-            break;
+        enum fuse_fill_dir_flags fill_flags = 0;
+
+        // readdirplus: 디렉터리 fd 기준 fstatat 로 속성까지 채워서 항목마다 getattr 왕복을 없앰
+        if (plus && fstatat(dirfd(d->dp), de->d_name, &st, AT_SYMLINK_NOFOLLOW) == 0) {
+            char child[PATH_MAX];
+            snprintf(child, sizeof(child), "%s/%s", strcmp(path, "/") == 0 ? "" : path, de->d_name);
+            mask_blacklisted(child, &st);
+            fill_flags = FUSE_FILL_DIR_PLUS;
+        } else {
+            memset(&st, 0, sizeof(st));
+            st.st_ino = de->d_ino;
+            st.st_mode = de->d_type << 12;
+        }
+        if (filler(buf, de->d_name, &st, next, fill_flags))
+            break; // 가득 참 -> d->entry 를 남겨두고 다음 호출에서 이어서
+        d->entry = NULL;
+        d->offset = next;
     }
+    return 0;
+}
 
-    closedir(dp);
+// releasedir 함수 구현
+static int myfs_releasedir(const char *path, struct fuse_file_info *fi) {
+    (void) path;
+    DirHandle *d = DH(fi);
+    closedir(d->dp);
+    free(d);
     return 0;
 }
 
@@ -208,11 +644,26 @@ static int myfs_open(const char *path, struct fuse_file_info *fi) {
     char relpath[PATH_MAX];
     get_relative_path(path, relpath);
 
-    res = openat(base_fd, relpath, fi->flags);
+    res = openat(base_fd, relpath, backend_open_flags(fi->flags));
     if (res == -1)
         return -errno;
 
-    fi->fh = res;
+    // 지난 open 이후 내용이 안 바뀌었으면 커널 페이지 캐시 유지
+    struct stat st;
+    if (fstat(res, &st) == 0 && mtime_unchanged(&st)) {
+        fi->keep_cache = 1;
+    }
+
+    int err = attach_file_handle(fi, res);
+    if (err != 0) {
+        return err;
+    }
+    attach_undo(fi, relpath);
+    if ((fi->flags & O_ACCMODE) == O_RDONLY) {
+        passthrough_open(fi);
+    } else {
+        passthrough_write_open(fi);
+    }
     return 0;
 }
 
@@ -227,11 +678,26 @@ static int myfs_create(const char *path, mode_t mode, struct fuse_file_info *fi)
     char relpath[PATH_MAX];
     get_relative_path(path, relpath);
 
-    res = openat(base_fd, relpath, fi->flags | O_CREAT, mode);
+    // 저널 모드: 이미 있는 파일의 O_TRUNC 는 원래 내용을 저널에 저장한 뒤 직접 자름
+    int trunc = g_config.undo_journal && (fi->flags & O_TRUNC);
+    res = openat(base_fd, relpath, (backend_open_flags(fi->flags) & ~(trunc ? O_TRUNC : 0)) | O_CREAT, mode);
     if (res == -1)
         return -errno;
 
-    fi->fh = res;
+    int err = attach_file_handle(fi, res);
+    if (err != 0) {
+        return err;
+    }
+    passthrough_write_open(fi);
+    attach_undo(fi, relpath);
+    if (trunc) {
+        undo_save_truncate(FH(fi)->undo, 0);
+        if (ftruncate(res, 0) == -1) {
+            err = -errno;
+            release_file_handle(FH(fi)); // 실패한 create 에는 release 가 오지 않음
+            return err;
+        }
+    }
     return 0;
 }
 
@@ -240,13 +706,50 @@ static int myfs_read(const char *path, char *buf, size_t size, off_t offset,
                      struct fuse_file_info *fi) {
     int res;
 
-    res = pread(fi->fh, buf, size, offset);
+    res = backend_io_pread(FH(fi)->fd, buf, size, offset);
     if (res == -1)
         res = -errno;
 
     return res;
 }
 
+/* read_buf 함수 구현 (read 보다 우선 사용됨)
+ - splice_read: 데이터를 읽지 않고 "백엔드 fd 의 offset 부터 size 바이트" 라는 버퍼만 돌려줌
+   -> libfuse 가 splice 로 백엔드 파일에서 /dev/fuse 로 바로 옮김 (사용자 공간 복사 없음)
+ - no_splice_read: 기존처럼 pread 로 메모리 버퍼에 읽어서 돌려줌 */
+static int myfs_read_buf(const char *path, struct fuse_bufvec **bufp, size_t size, off_t offset,
+                         struct fuse_file_info *fi) {
+    (void) path;
+    struct fuse_bufvec *src = malloc(sizeof(*src));
+    if (src == NULL) {
+        return -ENOMEM;
+    }
+    *src = FUSE_BUFVEC_INIT(size);
+
+    if (g_config.splice_read) {
+        src->buf[0].flags = FUSE_BUF_IS_FD | FUSE_BUF_FD_SEEK;
+        src->buf[0].fd = FH(fi)->fd;
+        src->buf[0].pos = offset;
+    } else {
+        char *mem = malloc(size);
+        if (mem == NULL) {
+            free(src);
+            return -ENOMEM;
+        }
+        ssize_t res = backend_io_pread(FH(fi)->fd, mem, size, offset);
+        if (res == -1) {
+            int err = errno;
+            free(mem);
+            free(src);
+            return -err;
+        }
+        src->buf[0].mem = mem;
+        src->buf[0].size = res;
+    }
+    *bufp = src;
+    return 0;
+}
+
 // write 함수 구현
 static int myfs_write(const char *path, const char *buf, size_t size, off_t offset,
                       struct fuse_file_info *fi) {
@@ -255,50 +758,70 @@ static int myfs_write(const char *path, const char *buf, size_t size, off_t offs
         return -EACCES; // 화이트리스트에 없으면 접근 거부
     }
 
-    // [RESTORE] 백업 함수 호출(쓰기 직전의 원본 확보)
-    restore_backup_on_write(path, base_fd);
-    
+    FileHandle *fh = FH(fi);
+
+    // PID 획득 (writeback 캐시면 write 는 커널이 나중에 모아서 보내므로 연 프로세스 기준)
+    struct fuse_context *context = fuse_get_context();
+    pid_t current_pid = g_writeback ? fh->owner : context->pid;
+
+    // [RESTORE] 백업 함수 호출(쓰기 직전의 원본 확보), 저널 모드는 pwrite 직전에 범위만 저장
+    // 백업본 확인은 핸들에 기억 (두 번째 write 부터는 색인 조회도 없음, 버전 모드는 핸들마다 새 버전)
+    if (fh->undo == NULL && !fh->backed_up) {
+        fh->backed_up = restore_backup_on_write_id(path, base_fd, fh->id_valid ? &fh->id : NULL, current_pid) == 0;
+    }
+
     // [restore] Truncation 및 fsync 실행 (CoW 직후 원본 지우고 동기화)
     if (fi->flags & O_TRUNC) {
-        if (ftruncate(fi->fh, 0) == -1) {
+        undo_save_truncate(fh->undo, 0);
+        if (ftruncate(fh->fd, 0) == -1) {
             fprintf(stderr, "RESTORE: Truncate failed after CoW prep.\n");
         }
         // fsync는 O_TRUNC 다음에 호출되어야 안전함
-        if (fsync(fi->fh) == -1) {
+        if (backend_io_fsync(fh->fd, 0) == -1) {
             fprintf(stderr, "RESTORE: Warning: fsync failed during CoW prep.\n");
         }
         fi->flags &= ~O_TRUNC; // 플래그를 제거하여 다음 write에 영향 없도록
     }
 
-    // PID 획득
-    struct fuse_context *context = fuse_get_context();
-    pid_t current_pid = context->pid;
-    
-    // Score 계산 및 갱신 -> (수정사항: get_score() 함수 사용함
-    int added_score = get_score("WRITE", buf, size);
-
-    update_malice_score(current_pid, added_score);
-    
-    
-    // 임계값 확인 후 강제 종료 조치
-    if (get_malice_score(current_pid) >= KILL_THRESHOLD) {
-        fprintf(stderr, "Kill ! 'write' 임계값 초과! PID %d 강제 종료\n", current_pid);
-        
-        //[RESTORE] 복구 함수 호출(KILL 됐을 때 원본 덮어쓰기)
-        restore_backup_file(path, base_fd);
-
-        // 강제 종료 실행
-        if (kill(current_pid, SIGKILL) == -1) {
-            fprintf(stderr, "킬 명령어 실패: %s\n", strerror(errno));
+    if (g_config.async_analyzer) {
+        // 비동기 모드: 워커가 이미 악성 판정한 프로세스면 차단, 아니면 이벤트만 넘기고 바로 쓰기
+        if (is_kill_pending(current_pid)) {
+            kill_and_restore(current_pid, path, "write");
+            return -EIO;
+        }
+        atomic_fetch_add(&fh->refs, 1); // 워커가 처리할 때까지 핸들 유지
+        pipeline_submit(current_pid, PIPE_OP_WRITE, path, buf, size, offset, fh);
+    } else {
+        // Score 계산 및 갱신 -> 핸들의 누적 엔트로피로 파일 전체 재작성 여부까지 판단
+        AnalyzerEvent ev = {
+            .op = ANALYZER_OP_WRITE, .pid = current_pid,
+            .offset = offset, .size = size, .buf = buf, .stream = &fh->stream,
+        };
+        pthread_mutex_lock(&fh->lock);
+        int added_score = get_event_score(&ev);
+        pthread_mutex_unlock(&fh->lock);
+
+        // 임계값 확인 후 강제 종료 조치
+        if (analyzer_record(current_pid, ANALYZER_OP_WRITE, added_score) >= KILL_THRESHOLD) {
+            kill_and_restore(current_pid, path, "write");
+
+            // 쓰기 연산 차단 및 에러 반환
+            return -EIO;
         }
-
-        // 쓰기 연산 차단 및 에러 반환
-        return -EIO; 
     }
 
     // 정상 연산 
+    // 이 프로세스가 수정한 파일로 기록 (kill 되면 같이 복구, 핸들마다 처음 한 번만)
+    if (fh->touched_by != current_pid) {
+        score_table_touch(current_pid, path);
+        fh->touched_by = current_pid;
+    }
+    // 저널 모드: 덮어쓸 범위 중 아직 저장 안 된 부분의 원래 데이터 저장 (실패해도 쓰기는 진행, 기존 백업과 같음)
+    if (fh->undo != NULL) {
+        undo_save(fh->undo, offset, size);
+    }
     int res;
-    res = pwrite(fi->fh, buf, size, offset);
+    res = backend_io_pwrite(fh->fd, buf, size, offset);
     if (res == -1) {
         res = -errno;
     }
@@ -307,11 +830,8 @@ static int myfs_write(const char *path, const char *buf, size_t size, off_t offs
 
 // release 함수 구현
 static int myfs_release(const char *path, struct fuse_file_info *fi) {
-    close(fi->fh);
-    struct fuse_context *context = fuse_get_context();
-    pid_t current_pid = context->pid;
-
-    reset_malice_score(current_pid); //파일 닫으면 해당 p의 score초기화
+    release_file_handle(FH(fi));
+    // 점수는 닫을 때 지우지 않음 (열고 닫기 반복으로 우회 가능) -> score_half_life 반감기로 줄어듦
     return 0;
 }
 
@@ -324,28 +844,37 @@ static int myfs_unlink(const char *path) {
     
     struct fuse_context *context = fuse_get_context(); //(새로추가) -> PID 획득
     pid_t current_pid = context->pid;
-    
-    int added_score = get_score("UNLINK", NULL, 0); //(새로추가) -> score 계산 (buf/size 가 없으므로 NULL,0 을 전달)
-    update_malice_score(current_pid, added_score); //(새로추가) -> 추가하기
-   
-    if(get_malice_score(current_pid) >= KILL_THRESHOLD) {//(if 문 전체 새로 추가)
-	    fprintf(stderr, "Kill ! 'unlink' 임계값 초과! PID %d 강제종료\n", current_pid);
-
-        //[RESTORE] 복구 함수 호출(KILL됐을 때 원본 복구)
-        restore_backup_file(path, base_fd);
 
-	    if(kill(current_pid,SIGKILL) == -1){
-		    fprintf(stderr, " 킬명령어 실패:%s\n", strerror(errno));
-	    }
-	    return -EIO;
+    if (g_config.async_analyzer) {
+        if (is_kill_pending(current_pid)) {
+            kill_and_restore(current_pid, path, "unlink");
+            return -EIO;
+        }
+        pipeline_submit(current_pid, PIPE_OP_UNLINK, path, NULL, 0, 0, NULL);
+    } else {
+        AnalyzerEvent ev = { .op = ANALYZER_OP_UNLINK, .pid = current_pid };
+        if(monitor_event(&ev) >= KILL_THRESHOLD) {//점수 + 빈도 벌점 추가, 임계값 확인 한 번에
+            kill_and_restore(current_pid, path, "unlink");
+            return -EIO;
+        }
+    }
+    score_table_touch(current_pid, path);
+    //[RESTORE] 지우는 대신 격리 (이름만 옮김, 크기와 무관), 격리 못 하면 그냥 삭제
+    if (restore_quarantine(path, base_fd, current_pid, 1, NULL) == 0) {
+        return 0;
     }
     int res;
     char relpath[PATH_MAX];
     get_relative_path(path, relpath);
 
+    struct stat st;
+    int last = undo_last_link(relpath, &st);
     res = unlinkat(base_fd, relpath, 0);
     if (res == -1)
         return -errno;
+    if (last) {
+        undo_discard(st.st_dev, st.st_ino);
+    }
 
     return 0;
 }
@@ -386,20 +915,21 @@ static int myfs_rename(const char *from, const char *to, unsigned int flags) {
     struct fuse_context *context = fuse_get_context(); //(새로추가) -> PID 획득
     pid_t current_pid = context->pid;
 
-    int added_score = get_score("RENAME", NULL, 0); //(새로추가) -> score 계산 (buf/size 가 없으므로 NULL,0 을 전달)
-    update_malice_score(current_pid, added_score); //(새로추가) -> 추가하기
-
-    if(get_malice_score(current_pid) >= KILL_THRESHOLD) {//(if 문 전체 새로 추가)
-            fprintf(stderr, "Kill ! 'rename' 임계값 초과! PID %d 강제종료\n", current_pid);
-            
+    if (g_config.async_analyzer) {
+        if (is_kill_pending(current_pid)) {
+            kill_and_restore(current_pid, from, "rename");
+            return -EIO;
+        }
+        pipeline_submit(current_pid, PIPE_OP_RENAME, from, NULL, 0, 0, NULL);
+    } else {
+        AnalyzerEvent ev = { .op = ANALYZER_OP_RENAME, .pid = current_pid };
+        if(monitor_event(&ev) >= KILL_THRESHOLD) {//점수 + 빈도 벌점 추가, 임계값 확인 한 번에
             //[RESTORE] 복구 함수 호출 ('from' 경로에 원본을 복원)
-            restore_backup_file(from, base_fd);
-            
-            if(kill(current_pid,SIGKILL) == -1){
-                    fprintf(stderr, " 킬명령어 실패:%s\n", strerror(errno));
-            }
+            kill_and_restore(current_pid, from, "rename");
             return -EIO;
+        }
     }
+    score_table_touch(current_pid, from); // 복구는 원래 이름으로
     int res;
     char relfrom[PATH_MAX];
     char relto[PATH_MAX];
@@ -409,9 +939,26 @@ static int myfs_rename(const char *from, const char *to, unsigned int flags) {
     if (flags)
         return -EINVAL;
 
+    //[RESTORE] 덮어쓰일 목적지가 있으면 링크로 격리 (목적지 이름도 복구 대상)
+    uint64_t token;
+    int quarantined = restore_quarantine(to, base_fd, current_pid, 0, &token) == 0;
+    // 격리 못 한 목적지는 덮어써지면 사라짐 (격리했으면 링크가 남아 있음)
+    struct stat st;
+    int last = undo_last_link(relto, &st);
     res = renameat(base_fd, relfrom, base_fd, relto);
-    if (res == -1)
-        return -errno;
+    if (res == -1) {
+        res = -errno;
+        if (quarantined) {
+            restore_unquarantine(to, current_pid, token); // 목적지는 그대로 -> 격리본이 남으면 한도만 차지
+        }
+        return res;
+    }
+    if (quarantined) {
+        score_table_touch(current_pid, to);
+    }
+    if (last) {
+        undo_discard(st.st_dev, st.st_ino);
+    }
 
     return 0;
 }
@@ -425,7 +972,7 @@ static int myfs_utimens(const char *path, const struct timespec tv[2],
 
     if (fi != NULL && fi->fh != 0) {
         // 파일 핸들이 있는 경우
-        res = futimens(fi->fh, tv);
+        res = futimens(FH(fi)->fd, tv);
     } else {
         // 파일 핸들이 없는 경우
         res = utimensat(base_fd, relpath, tv, 0);
@@ -436,13 +983,91 @@ static int myfs_utimens(const char *path, const struct timespec tv[2],
     return 0;
 }
 
+// init 함수 구현 (fuse_main 이 데몬화한 뒤 호출되므로 워커 스레드는 여기서 시작)
+static void *myfs_init(struct fuse_conn_info *conn, struct fuse_config *cfg) {
+    // 커널 속성/이름 캐시 (ls -l, 빌드 트리 탐색에서 getattr/lookup 왕복 감소)
+    cfg->attr_timeout = g_config.attr_timeout;
+    cfg->entry_timeout = g_config.entry_timeout;
+    cfg->negative_timeout = g_config.negative_timeout;
+    conn->want |= conn->capable & FUSE_CAP_READDIRPLUS;
+
+    // 큰 write: 요청 하나를 1MB 까지 (분석/백업 검사/pwrite 호출 횟수 감소)
+    conn->max_write = MYFS_MAX_WRITE;
+    if (g_config.writeback_cache && (conn->capable & FUSE_CAP_WRITEBACK_CACHE)) {
+        conn->want |= FUSE_CAP_WRITEBACK_CACHE;
+        g_writeback = 1;
+    }
+    fprintf(stderr, "INFO: max_write %u, writeback cache: %s\n", conn->max_write, g_writeback ? "on" : "off");
+
+    // read_buf 가 fd 버퍼를 돌려주면 응답을 splice 로 /dev/fuse 에 씀
+    if (g_config.splice_read) {
+        conn->want |= conn->capable & (FUSE_CAP_SPLICE_WRITE | FUSE_CAP_SPLICE_MOVE);
+    }
+#ifdef FUSE_CAP_PASSTHROUGH
+    // 커널이 passthrough 를 지원할 때만 켬 (아니면 기존 read 경로)
+    // writeback 캐시와는 같이 못 씀 (커널이 passthrough 를 거부)
+    if (g_config.passthrough && !g_writeback && (conn->capable & FUSE_CAP_PASSTHROUGH)) {
+        conn->want |= FUSE_CAP_PASSTHROUGH;
+        if (conn->max_backing_stack_depth == 0) {
+            conn->max_backing_stack_depth = 1; // 0 이면 커널이 passthrough 를 켜지 않음 (백엔드는 일반 파일시스템)
+        }
+        atomic_store(&g_passthrough, 1);
+    }
+    fprintf(stderr, "INFO: FUSE passthrough: %s\n", atomic_load(&g_passthrough) ? "on" : "off");
+#endif
+
+    // 백엔드 I/O 엔진 (스레드별 링은 FUSE 워커 스레드가 처음 쓸 때 생성)
+    if (g_config.uring) {
+        backend_io_init(g_config.uring_depth);
+    }
+    fprintf(stderr, "INFO: backend I/O: %s\n", backend_io_name());
+
+    // kill 시 병렬 복구 워커 (시작 못 하면 요청 스레드에서 직접 복구)
+    rollback_start(g_config.rollback_threads, base_fd, rollback_path);
+    // 버전 저장소 정리 스레드 (용량 한도/보관 기간)
+    restore_start_workers();
+
+    if (g_config.async_analyzer) {
+        if (pipeline_start(g_config.analyzer_threads, g_config.analyzer_queue, myfs_handle_event) != 0) {
+            fprintf(stderr, "PIPELINE: 워커 시작 실패, 동기 분석으로 전환\n");
+            g_config.async_analyzer = 0;
+        }
+    }
+    return NULL;
+}
+
+// destroy 함수 구현 (언마운트 시 남은 이벤트 처리 후 워커 종료)
+static void myfs_destroy(void *private_data) {
+    (void) private_data;
+
+    if (g_config.async_analyzer) {
+        uint64_t depth, drops, processed;
+        pipeline_stats(&depth, &drops, &processed);
+        pipeline_stop();
+        fprintf(stderr, "PIPELINE: 처리 %lu, 링 가득 참(직접 처리) %lu, 종료 시 대기 %lu\n",
+                (unsigned long)processed, (unsigned long)drops, (unsigned long)depth);
+    }
+
+    // 진행 중인 복구는 끝까지 마침
+    uint64_t pending, done, failed;
+    rollback_stats(&pending, &done, &failed);
+    rollback_stop();
+    fprintf(stderr, "ROLLBACK: 복구 %lu, 실패 %lu, 종료 시 대기 %lu\n",
+            (unsigned long)done, (unsigned long)failed, (unsigned long)pending);
+}
+
 // 파일시스템 연산자 구조체
 static const struct fuse_operations myfs_oper = {
+    .init       = myfs_init,
+    .destroy    = myfs_destroy,
     .getattr    = myfs_getattr,
+    .opendir    = myfs_opendir,
     .readdir    = myfs_readdir,
+    .releasedir = myfs_releasedir,
     .open       = myfs_open,
     .create     = myfs_create,
     .read       = myfs_read,
+    .read_buf   = myfs_read_buf,
     .write      = myfs_write,
     .release    = myfs_release,
     .unlink     = myfs_unlink,
@@ -461,6 +1086,11 @@ int main(int argc, char *argv[]) {
         return -1;
     }
 
+    // 우리 옵션만 골라내고 나머지는 fuse_main 으로 넘김
+    if (fuse_opt_parse(&args, &g_config, myfs_opts, NULL) == -1) {
+        return -1;
+    }
+
     // 마운트 포인트 경로 저장
     char *mountpoint = realpath(argv[argc - 1], NULL);
     if (mountpoint == NULL) {
@@ -490,14 +1120,28 @@ int main(int argc, char *argv[]) {
 
  
     // [RESTORE] 초기화(경로) 호출
+    restore_set_dedup(g_config.dedup_backup);
+    restore_set_compress(g_config.compress_backup);
+    restore_set_versions(g_config.versioned_backup, (uint64_t)g_config.backup_quota_mb << 20,
+                         g_config.backup_max_age);
+    restore_set_quarantine(g_config.quarantine, g_config.quarantine_max_age);
+    restore_set_journal(g_config.backup_journal);
     if (restore_init(home_dir, backend_path) != 0) {
         close(base_fd);
         return -1;
     }
 
+    // 분석기 설정 (엔트로피 표본 추정 모드)
+    analyzer_set_entropy_sampling(g_config.entropy_sample, g_config.sample_blocks,
+                                  g_config.sample_block_size, g_config.entropy_sample_random);
+    fprintf(stderr, "INFO: Entropy kernel: %s, sampling: %s\n", entropy_kernel_name(),
+            g_config.entropy_sample ? "on" : "off");
+    score_table_set_half_life(g_config.score_half_life);
+
     // FUSE 파일시스템 실행
     int ret = fuse_main(args.argc, args.argv, &myfs_oper, NULL);
 
+    fuse_opt_free_args(&args);
     close(base_fd);
     return ret;
 }
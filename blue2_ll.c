@@ -0,0 +1,875 @@
+#define FUSE_USE_VERSION FUSE_MAKE_VERSION(3, 12) // 3.12 루프 설정 API (fuse_loop_config_create) 사용
+#define _GNU_SOURCE
+#include <fuse3/fuse_lowlevel.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <dirent.h>
+#include <limits.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "restore.h" //[RESTORE]
+#include "score_table.h"
+#include "analyzer.h"
+#include "entropy.h"
+#define KILL_THRESHOLD 80    // Malice Score 강제 종료 임계값 (blue2.c 와 같은 값)
+
+/* 저수준(fuse_lowlevel_ops) 엔진
+ blue2.c 는 콜백마다 전체 경로 문자열을 받아 백엔드에서 경로를 다시 따라감 (openat/fstatat/unlinkat)
+ 여기서는 FUSE nodeid 마다 O_PATH fd 를 캐시해두고 (lookup/forget 으로 참조 카운트)
+ 백엔드 호출은 항상 "부모 fd + 이름 하나" 또는 "자기 fd" 기준으로 함
+ -> 깊은 트리에서도 경로 탐색이 한 번, 분석기/복구는 경로 대신 (dev, ino) 로 파일을 식별 */
+
+// 마운트 옵션 (blue2.c 와 같은 이름)
+struct myfs_config {
+    int entropy_sample;
+    int entropy_sample_random;
+    unsigned long sample_blocks;
+    unsigned long sample_block_size;
+    unsigned score_half_life;
+    double attr_timeout;
+    double entry_timeout;
+};
+static struct myfs_config g_config = {
+    .score_half_life = 30,
+    .attr_timeout = 5.0,
+    .entry_timeout = 5.0,
+};
+
+#define MYFS_OPT(t, p, v) { t, offsetof(struct myfs_config, p), v }
+static const struct fuse_opt myfs_opts[] = {
+    MYFS_OPT("entropy_sample", entropy_sample, 1),
+    MYFS_OPT("entropy_sample_random", entropy_sample_random, 1),
+    MYFS_OPT("entropy_sample_blocks=%lu", sample_blocks, 0),
+    MYFS_OPT("entropy_sample_block_size=%lu", sample_block_size, 0),
+    MYFS_OPT("score_half_life=%u", score_half_life, 0),
+    MYFS_OPT("attr_timeout=%lf", attr_timeout, 0),
+    MYFS_OPT("entry_timeout=%lf", entry_timeout, 0),
+    FUSE_OPT_END
+};
+
+// 블랙리스트 / 쓰기 화이트리스트 (blue2.c 와 같은 목록, 마운트 루트 바로 아래 이름)
+static const char *blacklist[] = {
+    "/ransomware.exe",
+    NULL
+};
+static const char *writable_whitelist[] = {
+    "/text.txt",
+    NULL
+};
+
+// 캐시된 백엔드 inode 하나 (nodeid = 이 구조체 주소)
+#define INODE_BLACKLISTED 0x1   // 실행 권한 숨김
+#define INODE_WRITABLE    0x2   // 쓰기 허용
+typedef struct Inode {
+    int fd;                 // O_PATH fd
+    dev_t dev;
+    ino_t ino;
+    uint64_t nlookup;       // 커널이 들고 있는 참조 수 (0 이 되면 fd 닫고 해제)
+    int flags;              // INODE_*
+    struct Inode *next;     // 해시 체인
+} Inode;
+
+static Inode g_root;
+static pthread_mutex_t g_inode_lock = PTHREAD_MUTEX_INITIALIZER;
+static Inode **g_buckets = NULL;
+static size_t g_bucket_count = 0;   // 2의 거듭제곱
+static size_t g_inode_count = 0;
+
+static inline size_t inode_hash(dev_t dev, ino_t ino) {
+    return (size_t)(((uint64_t)ino ^ ((uint64_t)dev << 32)) * 0x9E3779B97F4A7C15ULL >> 16);
+}
+
+static Inode *inode_of(fuse_ino_t ino) {
+    return ino == FUSE_ROOT_ID ? &g_root : (Inode *)(uintptr_t)ino;
+}
+
+// g_inode_lock 잡은 상태에서 호출
+static Inode *inode_find(dev_t dev, ino_t ino) {
+    if (g_bucket_count == 0) {
+        return NULL;
+    }
+    for (Inode *in = g_buckets[inode_hash(dev, ino) & (g_bucket_count - 1)]; in; in = in->next) {
+        if (in->ino == ino && in->dev == dev) {
+            return in;
+        }
+    }
+    return NULL;
+}
+
+// g_inode_lock 잡은 상태에서 호출 (평균 체인 길이 1 이하 유지)
+static int inode_insert(Inode *in) {
+    if (g_inode_count + 1 > g_bucket_count) {
+        size_t new_count = g_bucket_count ? g_bucket_count * 2 : 1024;
+        Inode **buckets = calloc(new_count, sizeof(Inode *));
+        if (buckets == NULL) {
+            return -1;
+        }
+        for (size_t i = 0; i < g_bucket_count; i++) {
+            Inode *p = g_buckets[i];
+            while (p) {
+                Inode *next = p->next;
+                size_t b = inode_hash(p->dev, p->ino) & (new_count - 1);
+                p->next = buckets[b];
+                buckets[b] = p;
+                p = next;
+            }
+        }
+        free(g_buckets);
+        g_buckets = buckets;
+        g_bucket_count = new_count;
+    }
+    size_t b = inode_hash(in->dev, in->ino) & (g_bucket_count - 1);
+    in->next = g_buckets[b];
+    g_buckets[b] = in;
+    g_inode_count++;
+    return 0;
+}
+
+// g_inode_lock 잡은 상태에서 호출
+static void inode_remove(Inode *in) {
+    Inode **pp = &g_buckets[inode_hash(in->dev, in->ino) & (g_bucket_count - 1)];
+    while (*pp != in) {
+        pp = &(*pp)->next;
+    }
+    *pp = in->next;
+    g_inode_count--;
+}
+
+static void forget_one(fuse_ino_t ino, uint64_t n) {
+    Inode *in = inode_of(ino);
+    if (in == &g_root) {
+        return;
+    }
+    pthread_mutex_lock(&g_inode_lock);
+    in->nlookup -= n;
+    int dead = in->nlookup == 0;
+    if (dead) {
+        inode_remove(in);
+    }
+    pthread_mutex_unlock(&g_inode_lock);
+    if (dead) {
+        close(in->fd);
+        free(in);
+    }
+}
+
+// 목록은 "/이름" 형식 -> 부모가 루트일 때 이름만 비교
+static int root_name_listed(const char **list, const Inode *dir, const char *name) {
+    if (dir != &g_root) {
+        return 0;
+    }
+    for (int i = 0; list[i] != NULL; i++) {
+        if (strcmp(list[i] + 1, name) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// 이름으로 정해지는 INODE_* (lookup 때마다, rename 뒤에 다시 계산)
+static int name_flags(const Inode *dir, const char *name) {
+    return (root_name_listed(blacklist, dir, name) ? INODE_BLACKLISTED : 0) |
+           (root_name_listed(writable_whitelist, dir, name) ? INODE_WRITABLE : 0);
+}
+
+static void mask_blacklisted(const Inode *in, struct stat *st) {
+    if ((in->flags & INODE_BLACKLISTED) && S_ISREG(st->st_mode)) {
+        st->st_mode &= ~(S_IXUSR | S_IXGRP | S_IXOTH);
+    }
+}
+
+// O_PATH fd 를 실제로 다시 열 때 쓰는 경로 (경로 탐색 없이 커널이 fd 를 바로 따라감)
+static void fd_proc_path(char *out, size_t len, int fd) {
+    snprintf(out, len, "/proc/self/fd/%d", fd);
+}
+
+/* parent 아래 name 을 찾아 inode 테이블에 등록 (이미 있으면 참조만 증가)
+ - 반환: 0 또는 errno */
+static int do_lookup(fuse_ino_t parent, const char *name, struct fuse_entry_param *e) {
+    Inode *dir = inode_of(parent);
+    memset(e, 0, sizeof(*e));
+    e->attr_timeout = g_config.attr_timeout;
+    e->entry_timeout = g_config.entry_timeout;
+
+    int fd = openat(dir->fd, name, O_PATH | O_NOFOLLOW);
+    if (fd == -1) {
+        return errno;
+    }
+    if (fstatat(fd, "", &e->attr, AT_EMPTY_PATH | AT_SYMLINK_NOFOLLOW) == -1) {
+        int err = errno;
+        close(fd);
+        return err;
+    }
+
+    pthread_mutex_lock(&g_inode_lock);
+    Inode *in = inode_find(e->attr.st_dev, e->attr.st_ino);
+    if (in != NULL) {
+        in->nlookup++;
+        in->flags = name_flags(dir, name);
+        pthread_mutex_unlock(&g_inode_lock);
+        close(fd);
+    } else {
+        in = calloc(1, sizeof(*in));
+        if (in != NULL) {
+            in->fd = fd;
+            in->dev = e->attr.st_dev;
+            in->ino = e->attr.st_ino;
+            in->nlookup = 1;
+            in->flags = name_flags(dir, name);
+        }
+        if (in == NULL || inode_insert(in) != 0) {
+            pthread_mutex_unlock(&g_inode_lock);
+            free(in);
+            close(fd);
+            return ENOMEM;
+        }
+        pthread_mutex_unlock(&g_inode_lock);
+    }
+    e->ino = (uintptr_t)in;
+    mask_blacklisted(in, &e->attr);
+    return 0;
+}
+
+// 열린 파일마다 fi->fh 에 달아두는 상태
+typedef struct {
+    int fd;
+    pthread_mutex_t lock;   // 같은 핸들에 대한 동시 write 보호
+    WriteStream stream;     // 순차 write 누적 엔트로피
+    Inode *inode;
+    int backed_up;          // 이 핸들로 이미 CoW 백업을 했음
+    int truncate_pending;   // O_TRUNC open: 백업 뒤에 비움
+} LLFile;
+
+#define LLF(fi) ((LLFile *)(uintptr_t)(fi)->fh)
+
+static LLFile *llfile_new(int fd, Inode *in) {
+    LLFile *f = malloc(sizeof(*f));
+    if (f == NULL) {
+        return NULL;
+    }
+    f->fd = fd;
+    pthread_mutex_init(&f->lock, NULL);
+    write_stream_init(&f->stream);
+    f->inode = in;
+    f->backed_up = 0;
+    f->truncate_pending = 0;
+    return f;
+}
+
+// [RESTORE] 첫 write 직전에 원본 백업, O_TRUNC 로 열었으면 그 다음에 비움 (f->lock 잡고 호출)
+static void llfile_prepare_write(LLFile *f) {
+    if (!f->backed_up) {
+        char proc[64];
+        fd_proc_path(proc, sizeof(proc), f->inode->fd);
+        int src = open(proc, O_RDONLY);
+        if (src != -1) {
+            restore_backup_fd(src, f->inode->dev, f->inode->ino);
+            close(src);
+        }
+        f->backed_up = 1;
+    }
+    if (f->truncate_pending) {
+        if (ftruncate(f->fd, 0) == -1) {
+            fprintf(stderr, "RESTORE: Truncate failed after CoW prep.\n");
+        }
+        f->truncate_pending = 0;
+    }
+}
+
+// 임계값 넘은 프로세스: inode 기준으로 원본 복구 후 강제 종료
+static void kill_and_restore(pid_t pid, const Inode *in, const char *op) {
+    fprintf(stderr, "Kill ! '%s' 임계값 초과! PID %d 강제 종료\n", op, pid);
+
+    char proc[64];
+    fd_proc_path(proc, sizeof(proc), in->fd);
+    int fd = open(proc, O_WRONLY);
+    if (fd != -1) {
+        restore_file_fd(fd, in->dev, in->ino);
+        close(fd);
+    }
+    if (kill(pid, SIGKILL) == -1) {
+        fprintf(stderr, "킬 명령어 실패: %s\n", strerror(errno));
+    }
+}
+
+// parent/name 에 대한 unlink/rename 점수 (kill 되면 원본 복구 후 1 반환)
+static int score_name_op(fuse_req_t req, AnalyzerOp op, Inode *dir, const char *name, const char *op_name) {
+    pid_t pid = fuse_req_ctx(req)->pid;
+    struct stat st;
+    int have_st = fstatat(dir->fd, name, &st, AT_SYMLINK_NOFOLLOW) == 0;
+
+    AnalyzerEvent ev = { .op = op, .pid = pid, .inode = have_st ? st.st_ino : 0 };
+    if (monitor_event(&ev) < KILL_THRESHOLD) {
+        return 0;
+    }
+    fprintf(stderr, "Kill ! '%s' 임계값 초과! PID %d 강제 종료\n", op_name, pid);
+    if (have_st && S_ISREG(st.st_mode)) {
+        int fd = openat(dir->fd, name, O_WRONLY | O_NOFOLLOW);
+        if (fd != -1) {
+            restore_file_fd(fd, st.st_dev, st.st_ino);
+            close(fd);
+        }
+    }
+    if (kill(pid, SIGKILL) == -1) {
+        fprintf(stderr, "킬 명령어 실패: %s\n", strerror(errno));
+    }
+    return 1;
+}
+
+static void ll_init(void *userdata, struct fuse_conn_info *conn) {
+    (void) userdata;
+    conn->want |= conn->capable & (FUSE_CAP_SPLICE_WRITE | FUSE_CAP_SPLICE_MOVE | FUSE_CAP_READDIRPLUS);
+    restore_start_workers(); // 데몬화 뒤라 여기서 백업 스레드 시작
+}
+
+static void ll_lookup(fuse_req_t req, fuse_ino_t parent, const char *name) {
+    struct fuse_entry_param e;
+    int err = do_lookup(parent, name, &e);
+    if (err) {
+        fuse_reply_err(req, err);
+    } else {
+        fuse_reply_entry(req, &e);
+    }
+}
+
+static void ll_forget(fuse_req_t req, fuse_ino_t ino, uint64_t nlookup) {
+    forget_one(ino, nlookup);
+    fuse_reply_none(req);
+}
+
+static void ll_forget_multi(fuse_req_t req, size_t count, struct fuse_forget_data *forgets) {
+    for (size_t i = 0; i < count; i++) {
+        forget_one(forgets[i].ino, forgets[i].nlookup);
+    }
+    fuse_reply_none(req);
+}
+
+static void ll_getattr(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi) {
+    (void) fi;
+    Inode *in = inode_of(ino);
+    struct stat st;
+    if (fstatat(in->fd, "", &st, AT_EMPTY_PATH | AT_SYMLINK_NOFOLLOW) == -1) {
+        fuse_reply_err(req, errno);
+        return;
+    }
+    mask_blacklisted(in, &st);
+    fuse_reply_attr(req, &st, g_config.attr_timeout);
+}
+
+static void ll_setattr(fuse_req_t req, fuse_ino_t ino, struct stat *attr, int to_set, struct fuse_file_info *fi) {
+    Inode *in = inode_of(ino);
+    char proc[64];
+    fd_proc_path(proc, sizeof(proc), in->fd);
+
+    if (to_set & FUSE_SET_ATTR_MODE) {
+        if (chmod(proc, attr->st_mode) == -1) {
+            fuse_reply_err(req, errno);
+            return;
+        }
+    }
+    if (to_set & FUSE_SET_ATTR_SIZE) {
+        // 크기 변경은 쓰기와 같음 -> 화이트리스트 + 백업
+        if (!(in->flags & INODE_WRITABLE)) {
+            fuse_reply_err(req, EACCES);
+            return;
+        }
+        int res;
+        if (fi) {
+            LLFile *f = LLF(fi);
+            pthread_mutex_lock(&f->lock);
+            llfile_prepare_write(f);
+            res = ftruncate(f->fd, attr->st_size);
+            pthread_mutex_unlock(&f->lock);
+        } else {
+            int src = open(proc, O_RDONLY);
+            if (src != -1) {
+                restore_backup_fd(src, in->dev, in->ino);
+                close(src);
+            }
+            res = truncate(proc, attr->st_size);
+        }
+        if (res == -1) {
+            fuse_reply_err(req, errno);
+            return;
+        }
+    }
+    if (to_set & (FUSE_SET_ATTR_ATIME | FUSE_SET_ATTR_MTIME)) {
+        struct timespec tv[2];
+        tv[0].tv_sec = 0;
+        tv[0].tv_nsec = UTIME_OMIT;
+        tv[1] = tv[0];
+        if (to_set & FUSE_SET_ATTR_ATIME_NOW) {
+            tv[0].tv_nsec = UTIME_NOW;
+        } else if (to_set & FUSE_SET_ATTR_ATIME) {
+            tv[0] = attr->st_atim;
+        }
+        if (to_set & FUSE_SET_ATTR_MTIME_NOW) {
+            tv[1].tv_nsec = UTIME_NOW;
+        } else if (to_set & FUSE_SET_ATTR_MTIME) {
+            tv[1] = attr->st_mtim;
+        }
+        if (utimensat(AT_FDCWD, proc, tv, 0) == -1) {
+            fuse_reply_err(req, errno);
+            return;
+        }
+    }
+    ll_getattr(req, ino, fi);
+}
+
+static void ll_mkdir(fuse_req_t req, fuse_ino_t parent, const char *name, mode_t mode) {
+    if (mkdirat(inode_of(parent)->fd, name, mode) == -1) {
+        fuse_reply_err(req, errno);
+        return;
+    }
+    ll_lookup(req, parent, name);
+}
+
+static void ll_rmdir(fuse_req_t req, fuse_ino_t parent, const char *name) {
+    int res = unlinkat(inode_of(parent)->fd, name, AT_REMOVEDIR);
+    fuse_reply_err(req, res == -1 ? errno : 0);
+}
+
+static void ll_unlink(fuse_req_t req, fuse_ino_t parent, const char *name) {
+    Inode *dir = inode_of(parent);
+    if (!root_name_listed(writable_whitelist, dir, name)) {
+        fuse_reply_err(req, EACCES); // 화이트리스트에 없으면 삭제 거부
+        return;
+    }
+    if (score_name_op(req, ANALYZER_OP_UNLINK, dir, name, "unlink")) {
+        fuse_reply_err(req, EIO);
+        return;
+    }
+    int res = unlinkat(dir->fd, name, 0);
+    fuse_reply_err(req, res == -1 ? errno : 0);
+}
+
+static void ll_rename(fuse_req_t req, fuse_ino_t parent, const char *name,
+                      fuse_ino_t newparent, const char *newname, unsigned int flags) {
+    Inode *dir = inode_of(parent);
+    Inode *newdir = inode_of(newparent);
+    if (!root_name_listed(writable_whitelist, newdir, newname)) {
+        fuse_reply_err(req, EACCES); // 목적지가 화이트리스트에 없으면 거부
+        return;
+    }
+    if (flags) {
+        fuse_reply_err(req, EINVAL);
+        return;
+    }
+    if (score_name_op(req, ANALYZER_OP_RENAME, dir, name, "rename")) {
+        fuse_reply_err(req, EIO);
+        return;
+    }
+    int res = renameat(dir->fd, name, newdir->fd, newname);
+    if (res == -1) {
+        fuse_reply_err(req, errno);
+        return;
+    }
+    // 캐시된 inode 의 플래그는 옛 이름 기준 -> 새 이름으로 다시 계산
+    struct stat st;
+    if (fstatat(newdir->fd, newname, &st, AT_SYMLINK_NOFOLLOW) == 0) {
+        pthread_mutex_lock(&g_inode_lock);
+        Inode *in = inode_find(st.st_dev, st.st_ino);
+        if (in != NULL) {
+            in->flags = name_flags(newdir, newname);
+        }
+        pthread_mutex_unlock(&g_inode_lock);
+    }
+    fuse_reply_err(req, 0);
+}
+
+static void ll_open(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi) {
+    Inode *in = inode_of(ino);
+    int writing = (fi->flags & O_ACCMODE) != O_RDONLY;
+    if (writing && !(in->flags & INODE_WRITABLE)) {
+        fuse_reply_err(req, EACCES); // 없다면 접근 거부
+        return;
+    }
+
+    // [restore] O_TRUNC 는 백업 뒤로 미룸 (열자마자 내용이 지워지는 것 방지)
+    int truncate = (fi->flags & O_TRUNC) != 0;
+    char proc[64];
+    fd_proc_path(proc, sizeof(proc), in->fd);
+    int fd = open(proc, fi->flags & ~(O_TRUNC | O_NOFOLLOW | O_CREAT));
+    if (fd == -1) {
+        fuse_reply_err(req, errno);
+        return;
+    }
+    LLFile *f = llfile_new(fd, in);
+    if (f == NULL) {
+        close(fd);
+        fuse_reply_err(req, ENOMEM);
+        return;
+    }
+    f->truncate_pending = truncate && writing;
+    fi->fh = (uint64_t)(uintptr_t)f;
+    if (fuse_reply_open(req, fi) == -ENOENT) {
+        // 요청이 중단됨 -> release 가 안 오므로 직접 정리
+        close(fd);
+        pthread_mutex_destroy(&f->lock);
+        free(f);
+    }
+}
+
+static void ll_create(fuse_req_t req, fuse_ino_t parent, const char *name, mode_t mode, struct fuse_file_info *fi) {
+    Inode *dir = inode_of(parent);
+    if (!root_name_listed(writable_whitelist, dir, name)) {
+        fuse_reply_err(req, EACCES); // 쓰기(생성) 차단
+        return;
+    }
+    // 커널은 dentry 가 캐시에 없으면 이미 있는 파일에도 create 를 보냄
+    // -> O_EXCL 로 먼저 만들어 보고, 이미 있으면 ll_open 처럼 열기 (O_TRUNC 는 백업 뒤로)
+    int flags = fi->flags & ~(O_NOFOLLOW | O_TRUNC | O_CREAT | O_EXCL);
+    int created = 1;
+    int fd = openat(dir->fd, name, flags | O_CREAT | O_EXCL, mode);
+    if (fd == -1 && errno == EEXIST && !(fi->flags & O_EXCL)) {
+        created = 0;
+        fd = openat(dir->fd, name, flags);
+    }
+    if (fd == -1) {
+        fuse_reply_err(req, errno);
+        return;
+    }
+    struct fuse_entry_param e;
+    int err = do_lookup(parent, name, &e);
+    if (err) {
+        close(fd);
+        fuse_reply_err(req, err);
+        return;
+    }
+    LLFile *f = llfile_new(fd, inode_of(e.ino));
+    if (f == NULL) {
+        close(fd);
+        forget_one(e.ino, 1);
+        fuse_reply_err(req, ENOMEM);
+        return;
+    }
+    f->backed_up = created; // 새로 만든 파일은 지킬 원본이 없음
+    f->truncate_pending = !created && (fi->flags & O_TRUNC) && (fi->flags & O_ACCMODE) != O_RDONLY;
+    fi->fh = (uint64_t)(uintptr_t)f;
+    fuse_reply_create(req, &e, fi);
+}
+
+// read: 백엔드 fd 에서 /dev/fuse 로 splice (사용자 공간 복사 없음)
+static void ll_read(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off, struct fuse_file_info *fi) {
+    (void) ino;
+    struct fuse_bufvec buf = FUSE_BUFVEC_INIT(size);
+    buf.buf[0].flags = FUSE_BUF_IS_FD | FUSE_BUF_FD_SEEK;
+    buf.buf[0].fd = LLF(fi)->fd;
+    buf.buf[0].pos = off;
+    fuse_reply_data(req, &buf, FUSE_BUF_SPLICE_MOVE);
+}
+
+static void ll_write(fuse_req_t req, fuse_ino_t ino, const char *buf, size_t size, off_t off,
+                     struct fuse_file_info *fi) {
+    Inode *in = inode_of(ino);
+    LLFile *f = LLF(fi);
+    if (!(in->flags & INODE_WRITABLE)) {
+        fuse_reply_err(req, EACCES);
+        return;
+    }
+    pid_t pid = fuse_req_ctx(req)->pid;
+
+    AnalyzerEvent ev = {
+        .op = ANALYZER_OP_WRITE, .pid = pid, .inode = in->ino,
+        .offset = off, .size = size, .buf = buf, .stream = &f->stream,
+    };
+    pthread_mutex_lock(&f->lock);
+    llfile_prepare_write(f);
+    int added_score = get_event_score(&ev);
+    pthread_mutex_unlock(&f->lock);
+
+    if (analyzer_record(pid, ANALYZER_OP_WRITE, added_score) >= KILL_THRESHOLD) {
+        kill_and_restore(pid, in, "write");
+        fuse_reply_err(req, EIO);
+        return;
+    }
+
+    ssize_t res = pwrite(f->fd, buf, size, off);
+    if (res == -1) {
+        fuse_reply_err(req, errno);
+    } else {
+        fuse_reply_write(req, res);
+    }
+}
+
+static void ll_flush(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi) {
+    (void) ino;
+    LLFile *f = LLF(fi);
+    // 쓰지 않고 닫는 O_TRUNC open 도 백업 후 비워야 함
+    pthread_mutex_lock(&f->lock);
+    if (f->truncate_pending) {
+        llfile_prepare_write(f);
+    }
+    pthread_mutex_unlock(&f->lock);
+    fuse_reply_err(req, 0);
+}
+
+static void ll_fsync(fuse_req_t req, fuse_ino_t ino, int datasync, struct fuse_file_info *fi) {
+    (void) ino;
+    int res = datasync ? fdatasync(LLF(fi)->fd) : fsync(LLF(fi)->fd);
+    fuse_reply_err(req, res == -1 ? errno : 0);
+}
+
+static void ll_release(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi) {
+    (void) ino;
+    LLFile *f = LLF(fi);
+    close(f->fd);
+    pthread_mutex_destroy(&f->lock);
+    free(f);
+    fuse_reply_err(req, 0);
+}
+
+// 열린 디렉터리 (blue2.c 의 DirHandle 과 같은 방식으로 telldir 위치에서 이어 읽음)
+typedef struct {
+    DIR *dp;
+    off_t offset;
+    struct dirent *entry;
+} DirHandle;
+
+#define DH(fi) ((DirHandle *)(uintptr_t)(fi)->fh)
+
+static void ll_opendir(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi) {
+    DirHandle *d = malloc(sizeof(*d));
+    if (d == NULL) {
+        fuse_reply_err(req, ENOMEM);
+        return;
+    }
+    int fd = openat(inode_of(ino)->fd, ".", O_RDONLY | O_DIRECTORY);
+    if (fd == -1 || (d->dp = fdopendir(fd)) == NULL) {
+        int err = errno;
+        if (fd != -1) {
+            close(fd);
+        }
+        free(d);
+        fuse_reply_err(req, err);
+        return;
+    }
+    d->offset = 0;
+    d->entry = NULL;
+    fi->fh = (uint64_t)(uintptr_t)d;
+    fuse_reply_open(req, fi);
+}
+
+static int is_dot_or_dotdot(const char *name) {
+    return name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'));
+}
+
+// readdir/readdirplus 공통: 커널이 준 size 만큼만 채우고 다음 위치는 telldir 값으로 넘김
+static void do_readdir(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off,
+                       struct fuse_file_info *fi, int plus) {
+    DirHandle *d = DH(fi);
+    char *buf = malloc(size);
+    if (buf == NULL) {
+        fuse_reply_err(req, ENOMEM);
+        return;
+    }
+    if (off != d->offset) {
+        seekdir(d->dp, off);
+        d->entry = NULL;
+        d->offset = off;
+    }
+
+    char *p = buf;
+    size_t rem = size;
+    for (;;) {
+        if (d->entry == NULL) {
+            errno = 0;
+            d->entry = readdir(d->dp);
+            if (d->entry == NULL) {
+                break;
+            }
+        }
+        const char *name = d->entry->d_name;
+        off_t next = telldir(d->dp);
+        size_t entsize;
+
+        if (plus) {
+            // 항목마다 lookup 까지 해서 커널이 getattr/lookup 을 따로 보내지 않게 함
+            struct fuse_entry_param e;
+            int looked_up = 0;
+            if (is_dot_or_dotdot(name)) {
+                memset(&e, 0, sizeof(e));
+                e.attr.st_ino = d->entry->d_ino;
+                e.attr.st_mode = d->entry->d_type << 12;
+            } else if (do_lookup(ino, name, &e) == 0) {
+                looked_up = 1;
+            } else {
+                // 읽은 뒤 지워진 항목 등은 건너뜀 (목록 전체를 끊지 않음)
+                d->entry = NULL;
+                d->offset = next;
+                continue;
+            }
+            entsize = fuse_add_direntry_plus(req, p, rem, name, &e, next);
+            if (entsize > rem) {
+                if (looked_up) {
+                    forget_one(e.ino, 1); // 못 넣었으니 참조도 돌려줌
+                }
+                break;
+            }
+        } else {
+            struct stat st;
+            memset(&st, 0, sizeof(st));
+            st.st_ino = d->entry->d_ino;
+            st.st_mode = d->entry->d_type << 12;
+            entsize = fuse_add_direntry(req, p, rem, name, &st, next);
+            if (entsize > rem) {
+                break;
+            }
+        }
+        p += entsize;
+        rem -= entsize;
+        d->entry = NULL;
+        d->offset = next;
+    }
+
+    fuse_reply_buf(req, buf, size - rem);
+    free(buf);
+}
+
+static void ll_readdir(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off, struct fuse_file_info *fi) {
+    do_readdir(req, ino, size, off, fi, 0);
+}
+
+static void ll_readdirplus(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off, struct fuse_file_info *fi) {
+    do_readdir(req, ino, size, off, fi, 1);
+}
+
+static void ll_releasedir(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi) {
+    (void) ino;
+    DirHandle *d = DH(fi);
+    closedir(d->dp);
+    free(d);
+    fuse_reply_err(req, 0);
+}
+
+static void ll_statfs(fuse_req_t req, fuse_ino_t ino) {
+    struct statvfs st;
+    if (fstatvfs(inode_of(ino)->fd, &st) == -1) {
+        fuse_reply_err(req, errno);
+    } else {
+        fuse_reply_statfs(req, &st);
+    }
+}
+
+static const struct fuse_lowlevel_ops ll_oper = {
+    .init         = ll_init,
+    .lookup       = ll_lookup,
+    .forget       = ll_forget,
+    .forget_multi = ll_forget_multi,
+    .getattr      = ll_getattr,
+    .setattr      = ll_setattr,
+    .mkdir        = ll_mkdir,
+    .rmdir        = ll_rmdir,
+    .unlink       = ll_unlink,
+    .rename       = ll_rename,
+    .open         = ll_open,
+    .create       = ll_create,
+    .read         = ll_read,
+    .write        = ll_write,
+    .flush        = ll_flush,
+    .fsync        = ll_fsync,
+    .release      = ll_release,
+    .opendir      = ll_opendir,
+    .readdir      = ll_readdir,
+    .readdirplus  = ll_readdirplus,
+    .releasedir   = ll_releasedir,
+    .statfs       = ll_statfs,
+};
+
+int main(int argc, char *argv[]) {
+    struct fuse_args args = FUSE_ARGS_INIT(argc, argv);
+    struct fuse_cmdline_opts opts;
+    int ret = -1;
+
+    if (fuse_opt_parse(&args, &g_config, myfs_opts, NULL) == -1) {
+        return -1;
+    }
+    if (fuse_parse_cmdline(&args, &opts) != 0) {
+        return -1;
+    }
+    if (opts.show_help || opts.mountpoint == NULL) {
+        fprintf(stderr, "Usage: %s [options] <mountpoint>\n", argv[0]);
+        fuse_cmdline_help();
+        fuse_lowlevel_help();
+        ret = opts.show_help ? 0 : -1;
+        goto out_args;
+    }
+
+    // 지정된 경로 획득 (백엔드 경로: $HOME/workspace/target)
+    const char *home_dir = getenv("HOME");
+    if (!home_dir) {
+        fprintf(stderr, "Error: HOME environment variable not set.\n");
+        goto out_args;
+    }
+    char backend_path[PATH_MAX];
+    snprintf(backend_path, PATH_MAX, "%s/workspace/target", home_dir);
+    fprintf(stderr, "INFO: Protecting backend path: %s\n", backend_path);
+
+    // 루트 inode (forget 되지 않음)
+    g_root.fd = open(backend_path, O_PATH | O_DIRECTORY);
+    if (g_root.fd == -1) {
+        perror("Error opening backend directory");
+        goto out_args;
+    }
+    struct stat st;
+    if (fstat(g_root.fd, &st) == -1) {
+        perror("Error reading backend directory");
+        goto out_root;
+    }
+    g_root.dev = st.st_dev;
+    g_root.ino = st.st_ino;
+    g_root.nlookup = 2;
+
+    if (restore_init(home_dir, backend_path) != 0) {
+        goto out_root;
+    }
+
+    analyzer_set_entropy_sampling(g_config.entropy_sample, g_config.sample_blocks,
+                                  g_config.sample_block_size, g_config.entropy_sample_random);
+    score_table_set_half_life(g_config.score_half_life);
+    fprintf(stderr, "INFO: Entropy kernel: %s, sampling: %s\n", entropy_kernel_name(),
+            g_config.entropy_sample ? "on" : "off");
+
+    struct fuse_session *se = fuse_session_new(&args, &ll_oper, sizeof(ll_oper), NULL);
+    if (se == NULL) {
+        goto out_root;
+    }
+    if (fuse_set_signal_handlers(se) != 0) {
+        goto out_session;
+    }
+    if (fuse_session_mount(se, opts.mountpoint) != 0) {
+        goto out_signals;
+    }
+    fuse_daemonize(opts.foreground);
+
+    if (opts.singlethread) {
+        ret = fuse_session_loop(se);
+    } else {
+        struct fuse_loop_config *config = fuse_loop_config_create();
+        fuse_loop_config_set_clone_fd(config, opts.clone_fd);
+        fuse_loop_config_set_max_threads(config, opts.max_threads);
+        ret = fuse_session_loop_mt(se, config);
+        fuse_loop_config_destroy(config);
+    }
+
+    fuse_session_unmount(se);
+out_signals:
+    fuse_remove_signal_handlers(se);
+out_session:
+    fuse_session_destroy(se);
+out_root:
+    close(g_root.fd);
+out_args:
+    free(opts.mountpoint);
+    fuse_opt_free_args(&args);
+    return ret ? 1 : 0;
+}
@@ -0,0 +1,664 @@
+#include "chunk_store.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <limits.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+// 청크 크기: 최소 2KB, 평균 8KB, 최대 64KB
+#define CDC_MIN (2 * 1024)
+#define CDC_AVG (8 * 1024)
+#define CDC_MAX (64 * 1024)
+// FastCDC 정규화: 평균 전에는 어려운 마스크(15bit), 뒤에는 쉬운 마스크(11bit) -> 크기 분포가 평균 근처로 모임
+// 시프트 해시의 상위 비트를 써야 최근 64바이트 전체가 경계 판단에 들어감
+#define CDC_MASK_S (((1ULL << 15) - 1) << 49)
+#define CDC_MASK_L (((1ULL << 11) - 1) << 53)
+
+#define CAS_READ_BUF (1024 * 1024)
+#define MANIFEST_MAGIC 0x4e414d43u // "CMAN"
+#define CAS_INITIAL 4096
+
+typedef struct {
+    uint64_t h[2];
+} Hash128;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t key_len;     // 뒤에 key (NUL 없음)
+    uint64_t file_size;
+    uint64_t chunk_count; // key 뒤에 ChunkRef x chunk_count
+} ManifestHeader;
+
+typedef struct {
+    Hash128 hash;
+    uint32_t len;
+    uint32_t reserved;
+} ChunkRef;
+
+// 청크 참조 수 (refs 0 = 저장 안 됨, 칸은 남겨둠 -> 같은 해시가 다시 오면 재사용)
+typedef struct {
+    Hash128 hash;
+    uint32_t refs;
+    uint8_t used;
+    uint8_t writing;    // 처음 참조한 스레드가 파일을 쓰는 중 (다른 참조는 끝날 때까지 기다림)
+} ChunkEntry;
+
+static char g_cas_dir[PATH_MAX];
+static ChunkEntry *g_chunks = NULL;
+static size_t g_chunk_cap = 0, g_chunk_count = 0;
+static pthread_mutex_t g_cas_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_cas_cond = PTHREAD_COND_INITIALIZER; // 청크 쓰기 끝남 (writing 해제)
+static uint64_t g_gear[256];
+
+/* ---- 해시 (XXH64, 시드 두 개로 128bit) ---- */
+#define P64_1 0x9E3779B185EBCA87ULL
+#define P64_2 0xC2B2AE3D27D4EB4FULL
+#define P64_3 0x165667B19E3779F9ULL
+#define P64_4 0x85EBCA77C2B2AE63ULL
+#define P64_5 0x27D4EB2F165667C5ULL
+
+static inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t read64(const unsigned char *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t read32(const unsigned char *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t xxh_round(uint64_t acc, uint64_t input) {
+    acc += input * P64_2;
+    acc = rotl64(acc, 31);
+    return acc * P64_1;
+}
+
+static inline uint64_t xxh_merge(uint64_t acc, uint64_t val) {
+    acc ^= xxh_round(0, val);
+    return acc * P64_1 + P64_4;
+}
+
+static uint64_t xxh64(const void *data, size_t len, uint64_t seed) {
+    const unsigned char *p = data;
+    const unsigned char *end = p + len;
+    uint64_t h;
+
+    if (len >= 32) {
+        uint64_t v1 = seed + P64_1 + P64_2, v2 = seed + P64_2, v3 = seed, v4 = seed - P64_1;
+        const unsigned char *limit = end - 32;
+        do {
+            v1 = xxh_round(v1, read64(p));
+            v2 = xxh_round(v2, read64(p + 8));
+            v3 = xxh_round(v3, read64(p + 16));
+            v4 = xxh_round(v4, read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = xxh_merge(h, v1);
+        h = xxh_merge(h, v2);
+        h = xxh_merge(h, v3);
+        h = xxh_merge(h, v4);
+    } else {
+        h = seed + P64_5;
+    }
+    h += (uint64_t)len;
+
+    for (; p + 8 <= end; p += 8) {
+        h ^= xxh_round(0, read64(p));
+        h = rotl64(h, 27) * P64_1 + P64_4;
+    }
+    if (p + 4 <= end) {
+        h ^= (uint64_t)read32(p) * P64_1;
+        h = rotl64(h, 23) * P64_2 + P64_3;
+        p += 4;
+    }
+    for (; p < end; p++) {
+        h ^= (*p) * P64_5;
+        h = rotl64(h, 11) * P64_1;
+    }
+    h ^= h >> 33;
+    h *= P64_2;
+    h ^= h >> 29;
+    h *= P64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+static Hash128 hash128(const void *data, size_t len) {
+    Hash128 r = { { xxh64(data, len, 0), xxh64(data, len, 0x5bd1e9955bd1e995ULL) } };
+    return r;
+}
+
+static void hash_hex(char out[33], const Hash128 *h) {
+    snprintf(out, 33, "%016llx%016llx", (unsigned long long)h->h[0], (unsigned long long)h->h[1]);
+}
+
+/* ---- 청크 경계 (Gear rolling hash) ---- */
+
+// Gear 표: 고정 시드 splitmix64 (실행마다 같아야 같은 내용이 같은 경계로 잘림)
+static void gear_init(void) {
+    uint64_t x = 0x2545F4914F6CDD1DULL;
+    for (int i = 0; i < 256; i++) {
+        uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        g_gear[i] = z ^ (z >> 31);
+    }
+}
+
+// p[0..n) 앞에서 잘라낼 청크 길이 (n 이 CDC_MAX 보다 작으면 파일 끝인 경우에만 호출)
+static size_t cdc_cut(const unsigned char *p, size_t n) {
+    if (n <= CDC_MIN) {
+        return n;
+    }
+    size_t normal = n < CDC_AVG ? n : CDC_AVG;
+    size_t limit = n < CDC_MAX ? n : CDC_MAX;
+    uint64_t h = 0;
+    size_t i = CDC_MIN;
+    for (; i < normal; i++) {
+        h = (h << 1) + g_gear[p[i]];
+        if (!(h & CDC_MASK_S)) {
+            return i + 1;
+        }
+    }
+    for (; i < limit; i++) {
+        h = (h << 1) + g_gear[p[i]];
+        if (!(h & CDC_MASK_L)) {
+            return i + 1;
+        }
+    }
+    return limit;
+}
+
+/* ---- 청크 참조 표 (g_cas_lock 잡고 사용) ---- */
+
+static ChunkEntry *chunk_slot(const Hash128 *h) {
+    size_t mask = g_chunk_cap - 1;
+    for (size_t i = h->h[0] & mask;; i = (i + 1) & mask) {
+        ChunkEntry *e = &g_chunks[i];
+        if (!e->used || (e->hash.h[0] == h->h[0] && e->hash.h[1] == h->h[1])) {
+            return e;
+        }
+    }
+}
+
+static int chunk_table_grow(void) {
+    size_t cap = g_chunk_cap ? g_chunk_cap * 2 : CAS_INITIAL;
+    ChunkEntry *old = g_chunks;
+    size_t old_cap = g_chunk_cap;
+    ChunkEntry *slots = calloc(cap, sizeof(ChunkEntry));
+    if (slots == NULL) {
+        return -1;
+    }
+    g_chunks = slots;
+    g_chunk_cap = cap;
+    g_chunk_count = 0;
+    for (size_t i = 0; i < old_cap; i++) {
+        if (old[i].used && old[i].refs > 0) { // 참조 0 칸은 옮기지 않음
+            *chunk_slot(&old[i].hash) = old[i];
+            g_chunk_count++;
+        }
+    }
+    free(old);
+    return 0;
+}
+
+/* 참조 하나 추가, 반환: 1 = 새 청크 (파일을 쓰고 chunk_stored 호출), 0 = 이미 저장됨, -1 = 메모리 부족
+ 다른 스레드가 아직 쓰는 청크면 끝날 때까지 기다림 (그 쓰기가 실패하면 이 호출자가 씀)
+ -> 0 을 받은 호출자의 매니페스트는 항상 파일이 있는 청크만 가리킴 */
+static int chunk_ref(const Hash128 *h) {
+    for (;;) {
+        if ((g_chunk_count + 1) * 4 > g_chunk_cap * 3 && chunk_table_grow() != 0) {
+            return -1;
+        }
+        ChunkEntry *e = chunk_slot(h);
+        if (!e->used) {
+            e->hash = *h;
+            e->used = 1;
+            g_chunk_count++;
+        }
+        if (e->refs > 0 && e->writing) {
+            pthread_cond_wait(&g_cas_cond, &g_cas_lock); // 표가 커질 수 있으므로 깨면 다시 찾음
+            continue;
+        }
+        int fresh = e->refs++ == 0;
+        e->writing = fresh;
+        return fresh;
+    }
+}
+
+// 참조 하나 빼기, 반환: 1 = 참조 0 (파일 삭제), 0 = 남아 있음
+static int chunk_unref(const Hash128 *h) {
+    if (g_chunk_cap == 0) {
+        return 0;
+    }
+    ChunkEntry *e = chunk_slot(h);
+    if (!e->used || e->refs == 0) {
+        return 0;
+    }
+    return --e->refs == 0;
+}
+
+// chunk_ref 가 1 을 준 청크의 쓰기 끝 (실패면 참조를 되돌림), 기다리는 스레드 깨움
+static void chunk_stored(const Hash128 *h, int ok) {
+    ChunkEntry *e = chunk_slot(h);
+    e->writing = 0;
+    if (!ok) {
+        chunk_unref(h);
+    }
+    pthread_cond_broadcast(&g_cas_cond);
+}
+
+/* ---- 파일 경로 ---- */
+
+#define CAS_PATH_TAIL 44 // "/chunks/xx/" + 32자 해시 (g_cas_dir 뒤에 붙는 가장 긴 부분)
+
+// 반환: 0, 경로가 PATH_MAX 를 넘으면 -1
+static int chunk_path(char *out, const Hash128 *h) {
+    char hex[33];
+    hash_hex(hex, h);
+    return snprintf(out, PATH_MAX, "%s/chunks/%.2s/%s", g_cas_dir, hex, hex) < PATH_MAX ? 0 : -1;
+}
+
+static int manifest_path(char *out, const char *key) {
+    Hash128 h = hash128(key, strlen(key));
+    char hex[33];
+    hash_hex(hex, &h);
+    return snprintf(out, PATH_MAX, "%s/manifests/%s", g_cas_dir, hex) < PATH_MAX ? 0 : -1;
+}
+
+static ssize_t read_full(int fd, void *buf, size_t size, off_t offset) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = pread(fd, (char *)buf + done, size - done, offset + (off_t)done);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return n == 0 ? (ssize_t)done : -1;
+        }
+        done += n;
+    }
+    return done;
+}
+
+static int write_full(int fd, const void *buf, size_t size) {
+    const char *p = buf;
+    while (size > 0) {
+        ssize_t n = write(fd, p, size);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return -1;
+        }
+        p += n;
+        size -= n;
+    }
+    return 0;
+}
+
+// 임시 파일에 다 쓴 뒤 rename (중간에 끊겨도 반쯤 쓴 청크/매니페스트가 정식 이름으로 남지 않음)
+static int write_atomic(const char *path, const void *a, size_t alen, const void *b, size_t blen,
+                        const void *c, size_t clen) {
+    char tmp[PATH_MAX + 16];
+    snprintf(tmp, sizeof(tmp), "%s.tmp.%lx", path, (unsigned long)pthread_self());
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd == -1) {
+        return -1;
+    }
+    int ok = write_full(fd, a, alen) == 0 && write_full(fd, b, blen) == 0 && write_full(fd, c, clen) == 0;
+    close(fd);
+    if (!ok || rename(tmp, path) == -1) {
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+static int store_chunk(const Hash128 *h, const void *data, size_t len) {
+    char path[PATH_MAX];
+    if (chunk_path(path, h) != 0) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    if (write_atomic(path, data, len, NULL, 0, NULL, 0) == 0) {
+        return 0;
+    }
+    if (errno == ENOENT) { // 앞 2자리 디렉터리가 아직 없음
+        char dir[PATH_MAX];
+        snprintf(dir, sizeof(dir), "%.*s", (int)(strrchr(path, '/') - path), path);
+        if (mkdir(dir, 0700) == -1 && errno != EEXIST) {
+            return -1;
+        }
+        return write_atomic(path, data, len, NULL, 0, NULL, 0);
+    }
+    return -1;
+}
+
+/* 매니페스트 읽기 (key 가 다르면 경로 해시 충돌 -> 없는 것으로)
+ - 반환: 청크 목록 (호출자가 free), 실패 시 NULL */
+static ChunkRef *manifest_load(const char *path, const char *key, ManifestHeader *hdr, char **key_out) {
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return NULL;
+    }
+    ChunkRef *refs = NULL;
+    char *stored = NULL;
+    if (read_full(fd, hdr, sizeof(*hdr), 0) != sizeof(*hdr) || hdr->magic != MANIFEST_MAGIC ||
+        hdr->key_len >= PATH_MAX || hdr->chunk_count > (1ULL << 32)) {
+        goto fail;
+    }
+    stored = malloc(hdr->key_len + 1);
+    refs = malloc((hdr->chunk_count ? hdr->chunk_count : 1) * sizeof(ChunkRef));
+    if (stored == NULL || refs == NULL ||
+        read_full(fd, stored, hdr->key_len, sizeof(*hdr)) != (ssize_t)hdr->key_len) {
+        goto fail;
+    }
+    stored[hdr->key_len] = '\0';
+    if ((key != NULL && strcmp(stored, key) != 0) ||
+        read_full(fd, refs, hdr->chunk_count * sizeof(ChunkRef), sizeof(*hdr) + hdr->key_len) !=
+            (ssize_t)(hdr->chunk_count * sizeof(ChunkRef))) {
+        goto fail;
+    }
+    close(fd);
+    if (key_out != NULL) {
+        *key_out = stored;
+    } else {
+        free(stored);
+    }
+    return refs;
+fail:
+    close(fd);
+    free(stored);
+    free(refs);
+    return NULL;
+}
+
+/* ---- 초기화 / GC ---- */
+
+// 매니페스트마다 청크 참조 수 계산
+static size_t load_manifests(void (*on_manifest)(const char *key, void *arg), void *arg) {
+    char dir[PATH_MAX];
+    if (snprintf(dir, sizeof(dir), "%s/manifests", g_cas_dir) >= (int)sizeof(dir)) {
+        return 0;
+    }
+    DIR *dp = opendir(dir);
+    if (dp == NULL) {
+        return 0;
+    }
+    size_t count = 0;
+    struct dirent *de;
+    while ((de = readdir(dp)) != NULL) {
+        if (de->d_name[0] == '.') {
+            continue;
+        }
+        char path[PATH_MAX];
+        if (snprintf(path, sizeof(path), "%s/%s", dir, de->d_name) >= (int)sizeof(path)) {
+            continue;
+        }
+        if (strstr(de->d_name, ".tmp.") != NULL) {
+            unlink(path); // 끊긴 매니페스트 쓰기
+            continue;
+        }
+        ManifestHeader hdr;
+        char *key = NULL;
+        ChunkRef *refs = manifest_load(path, NULL, &hdr, &key);
+        if (refs == NULL) {
+            fprintf(stderr, "RESTORE: 경고: 손상된 매니페스트 %s 무시\n", path);
+            continue;
+        }
+        for (uint64_t i = 0; i < hdr.chunk_count; i++) {
+            chunk_ref(&refs[i].hash);
+        }
+        if (on_manifest != NULL) {
+            on_manifest(key, arg);
+        }
+        free(key);
+        free(refs);
+        count++;
+    }
+    closedir(dp);
+    return count;
+}
+
+// 참조 없는 청크 파일 삭제 (매니페스트를 쓰기 전에 끊긴 백업의 청크)
+static size_t collect_garbage(void) {
+    char dir[PATH_MAX];
+    if (snprintf(dir, sizeof(dir), "%s/chunks", g_cas_dir) >= (int)sizeof(dir)) {
+        return 0;
+    }
+    DIR *top = opendir(dir);
+    if (top == NULL) {
+        return 0;
+    }
+    size_t removed = 0;
+    struct dirent *sub;
+    while ((sub = readdir(top)) != NULL) {
+        if (sub->d_name[0] == '.') {
+            continue;
+        }
+        char subdir[PATH_MAX];
+        if (snprintf(subdir, sizeof(subdir), "%s/%s", dir, sub->d_name) >= (int)sizeof(subdir)) {
+            continue;
+        }
+        DIR *dp = opendir(subdir);
+        if (dp == NULL) {
+            continue;
+        }
+        struct dirent *de;
+        while ((de = readdir(dp)) != NULL) {
+            unsigned long long a, b;
+            if (de->d_name[0] == '.') {
+                continue;
+            }
+            int keep = 0;
+            if (strlen(de->d_name) == 32 && sscanf(de->d_name, "%16llx%16llx", &a, &b) == 2) {
+                Hash128 h = { { a, b } };
+                ChunkEntry *e = g_chunk_cap ? chunk_slot(&h) : NULL;
+                keep = e != NULL && e->used && e->refs > 0;
+            }
+            if (!keep) {
+                char path[PATH_MAX + 256];
+                snprintf(path, sizeof(path), "%s/%s", subdir, de->d_name);
+                unlink(path);
+                removed++;
+            }
+        }
+        closedir(dp);
+    }
+    closedir(top);
+    return removed;
+}
+
+int chunk_store_init(const char *backup_dir, void (*on_manifest)(const char *key, void *arg), void *arg) {
+    gear_init();
+    // 가장 긴 경로 (매니페스트/청크 파일) 까지 PATH_MAX 안에 들어가야 함
+    int len = snprintf(g_cas_dir, sizeof(g_cas_dir), "%s/cas", backup_dir);
+    if (len < 0 || len + CAS_PATH_TAIL >= PATH_MAX) {
+        fprintf(stderr, "RESTORE: 청크 저장소 경로가 너무 김: %s\n", backup_dir);
+        return -1;
+    }
+    char dir[PATH_MAX + 16];
+    const char *subs[] = { "", "/chunks", "/manifests" };
+    for (int i = 0; i < 3; i++) {
+        snprintf(dir, sizeof(dir), "%s%s", g_cas_dir, subs[i]);
+        if (mkdir(dir, 0700) == -1 && errno != EEXIST) {
+            perror("RESTORE: 청크 저장소 디렉터리 생성 실패");
+            return -1;
+        }
+    }
+    pthread_mutex_lock(&g_cas_lock);
+    if (g_chunk_cap == 0 && chunk_table_grow() != 0) {
+        pthread_mutex_unlock(&g_cas_lock);
+        return -1;
+    }
+    size_t manifests = load_manifests(on_manifest, arg);
+    size_t removed = collect_garbage();
+    size_t chunks = g_chunk_count;
+    pthread_mutex_unlock(&g_cas_lock);
+    fprintf(stderr, "RESTORE: 청크 저장소: 매니페스트 %zu개, 청크 %zu개, 참조 없는 청크 %zu개 정리\n",
+            manifests, chunks, removed);
+    return 0;
+}
+
+int chunk_store_has(const char *key) {
+    char path[PATH_MAX];
+    return manifest_path(path, key) == 0 && access(path, F_OK) == 0;
+}
+
+int chunk_store_backup(int src_fd, const char *key, ChunkStoreStats *stats) {
+    ChunkStoreStats local = { 0 };
+    char mpath[PATH_MAX];
+    if (manifest_path(mpath, key) != 0) {
+        return -1;
+    }
+    if (access(mpath, F_OK) == 0) {
+        if (stats != NULL) {
+            *stats = local;
+        }
+        return 0; // 처음 원본 유지
+    }
+
+    unsigned char *buf = malloc(CAS_READ_BUF);
+    ChunkRef *refs = NULL;
+    size_t nrefs = 0, cap = 0;
+    size_t start = 0, filled = 0;
+    off_t pos = 0;
+    int eof = 0, ret = -1;
+    if (buf == NULL) {
+        return -1;
+    }
+
+    for (;;) {
+        // 버퍼에 최대 청크보다 적게 남았으면 앞으로 당기고 더 읽음
+        if (!eof && filled - start < CDC_MAX) {
+            memmove(buf, buf + start, filled - start);
+            filled -= start;
+            start = 0;
+            ssize_t n = read_full(src_fd, buf + filled, CAS_READ_BUF - filled, pos);
+            if (n < 0) {
+                goto out;
+            }
+            pos += n;
+            filled += n;
+            eof = filled < CAS_READ_BUF;
+        }
+        if (start == filled) {
+            break;
+        }
+
+        size_t len = cdc_cut(buf + start, filled - start);
+        Hash128 h = hash128(buf + start, len);
+        pthread_mutex_lock(&g_cas_lock);
+        int fresh = chunk_ref(&h);
+        pthread_mutex_unlock(&g_cas_lock);
+        if (fresh < 0) {
+            goto out;
+        }
+        if (fresh) {
+            int ok = store_chunk(&h, buf + start, len) == 0;
+            pthread_mutex_lock(&g_cas_lock);
+            chunk_stored(&h, ok);
+            pthread_mutex_unlock(&g_cas_lock);
+            if (!ok) {
+                goto out;
+            }
+        }
+        if (nrefs == cap) {
+            cap = cap ? cap * 2 : 256;
+            ChunkRef *r = realloc(refs, cap * sizeof(ChunkRef));
+            if (r == NULL) {
+                goto out;
+            }
+            refs = r;
+        }
+        refs[nrefs].hash = h;
+        refs[nrefs].len = len;
+        refs[nrefs].reserved = 0;
+        nrefs++;
+        local.chunks++;
+        local.file_bytes += len;
+        if (fresh) {
+            local.new_chunks++;
+            local.new_bytes += len;
+        }
+        start += len;
+    }
+
+    ManifestHeader hdr = { MANIFEST_MAGIC, (uint32_t)strlen(key), local.file_bytes, nrefs };
+    ret = write_atomic(mpath, &hdr, sizeof(hdr), key, hdr.key_len, refs, nrefs * sizeof(ChunkRef));
+out:
+    if (ret != 0) {
+        // 이미 올린 참조 되돌림 (새로 쓴 청크는 참조가 0 이 되면 삭제)
+        pthread_mutex_lock(&g_cas_lock);
+        for (size_t i = 0; i < nrefs; i++) {
+            if (chunk_unref(&refs[i].hash)) {
+                char path[PATH_MAX];
+                if (chunk_path(path, &refs[i].hash) == 0) {
+                    unlink(path);
+                }
+            }
+        }
+        pthread_mutex_unlock(&g_cas_lock);
+    }
+    free(buf);
+    free(refs);
+    if (stats != NULL) {
+        *stats = local;
+    }
+    return ret;
+}
+
+int chunk_store_restore(const char *key, int dest_fd) {
+    char mpath[PATH_MAX];
+    if (manifest_path(mpath, key) != 0) {
+        return -1;
+    }
+    ManifestHeader hdr;
+    ChunkRef *refs = manifest_load(mpath, key, &hdr, NULL);
+    if (refs == NULL) {
+        return -1;
+    }
+    unsigned char *buf = malloc(CDC_MAX);
+    int ret = buf == NULL ? -1 : 0;
+    off_t off = 0;
+    for (uint64_t i = 0; i < hdr.chunk_count && ret == 0; i++) {
+        char path[PATH_MAX];
+        int fd = chunk_path(path, &refs[i].hash) == 0 ? open(path, O_RDONLY) : -1;
+        if (fd == -1 || refs[i].len > CDC_MAX ||
+            read_full(fd, buf, refs[i].len, 0) != (ssize_t)refs[i].len) {
+            fprintf(stderr, "RESTORE: 청크 읽기 실패: %s\n", path);
+            ret = -1;
+        } else {
+            Hash128 h = hash128(buf, refs[i].len);
+            if (h.h[0] != refs[i].hash.h[0] || h.h[1] != refs[i].hash.h[1]) {
+                fprintf(stderr, "RESTORE: 청크 내용이 해시와 다름: %s\n", path);
+                ret = -1;
+            } else if (pwrite(dest_fd, buf, refs[i].len, off) != (ssize_t)refs[i].len) {
+                ret = -1;
+            }
+        }
+        if (fd != -1) {
+            close(fd);
+        }
+        off += refs[i].len;
+    }
+    if (ret == 0 && ftruncate(dest_fd, hdr.file_size) == -1) {
+        ret = -1;
+    }
+    free(buf);
+    free(refs);
+    return ret;
+}
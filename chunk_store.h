@@ -0,0 +1,38 @@
+#ifndef CHUNK_STORE_H
+#define CHUNK_STORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/* 내용 기반 청크 백업 저장소 (중복 제거)
+ 파일을 rolling hash (Gear/FastCDC) 로 가변 길이 청크로 자르고, 청크는 내용 해시 이름으로 한 번만 저장
+ 파일마다 매니페스트 (전체 상대 경로, 크기, 청크 목록) -> 이름이 같은 다른 디렉터리 파일도 충돌 없음
+ - <백업dir>/cas/chunks/<해시 앞 2자리>/<해시 32자리>
+ - <백업dir>/cas/manifests/<경로 해시 32자리>
+ - 청크 참조 수는 메모리에만 두고 시작할 때 매니페스트를 읽어 다시 셈 (매니페스트가 기준)
+ - 매니페스트는 지우지 않음 (이름 백업처럼 처음 원본 유지) -> 참조 수는 실패한 백업 되돌리기와
+   시작 시 참조 없는 청크 정리에만 씀
+ - 해시는 비암호 128bit (빠른 식별용), 복구 때 청크 내용을 다시 해시해서 확인 */
+
+typedef struct {
+    uint64_t file_bytes;  // 원본 크기
+    uint64_t new_bytes;   // 이번에 새로 저장한 청크 바이트 (나머지는 기존 청크 재사용)
+    uint64_t chunks;
+    uint64_t new_chunks;
+} ChunkStoreStats;
+
+/* 저장소 열기: 디렉터리 생성, 매니페스트로 참조 수 계산, 참조 없는 청크 (중간에 끊긴 백업) 삭제
+ - on_manifest: 매니페스트마다 원래 상대 경로로 호출 (백업 색인 채우기용, NULL 가능) */
+int chunk_store_init(const char *backup_dir, void (*on_manifest)(const char *key, void *arg), void *arg);
+
+int chunk_store_has(const char *key); // key(상대 경로) 의 매니페스트가 있는지
+
+/* src_fd 처음부터 끝까지를 청크로 저장하고 key 의 매니페스트 기록 (이미 있으면 그대로 둠)
+ - 반환: 0 = 성공/이미 있음, -1 = 실패 */
+int chunk_store_backup(int src_fd, const char *key, ChunkStoreStats *stats);
+
+// 매니페스트대로 dest_fd 를 다시 만듦 (처음부터 쓰고 원래 크기로 자름)
+int chunk_store_restore(const char *key, int dest_fd);
+
+#endif
@@ -1,46 +1,484 @@
 ﻿#include <math.h>
 #include <string.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "entropy.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define ENTROPY_HAVE_X86 1
+#endif
+
+#define ENTROPY_SUB_HISTOGRAMS 4 // 같은 바이트 연속 증가(store-to-load 지연)를 막기 위한 보조 히스토그램 개수
+#define ENTROPY_CLOGC_TABLE 4096 // c*log2(c) 를 미리 계산해둘 빈도 범위 (0~4095)
+#define ENTROPY_SLICE (1u << 30) // uint32 보조 히스토그램이 넘치지 않도록 나눠서 처리하는 단위
+
+#define SERIAL_FLUSH_BLOCKS 8192 // SIMD 32비트 누적값이 넘치기 전에 64비트로 옮기는 주기
+
+typedef void (*histogram_kernel_t)(const unsigned char *p, size_t n, uint32_t sub[ENTROPY_SUB_HISTOGRAMS][256]);
+// 히스토그램 + 이웃 바이트 곱의 합(Σ x[i]*x[i+1]) 을 한 번에 구하는 커널
+typedef void (*serial_kernel_t)(const unsigned char *p, size_t n, uint32_t sub[ENTROPY_SUB_HISTOGRAMS][256],
+                                uint64_t *serial);
+
+static double g_clogc[ENTROPY_CLOGC_TABLE]; // g_clogc[c] = c * log2(c)
+static histogram_kernel_t g_histogram_kernel;
+static serial_kernel_t g_serial_kernel;
+static const char *g_kernel_name = "scalar";
+static pthread_once_t g_entropy_once = PTHREAD_ONCE_INIT;
+
+// 8바이트 단어 하나를 4개의 보조 히스토그램에 나눠서 누적
+#define HIST_WORD(sub, w) do { \
+        (sub)[0][(uint8_t)(w)]++;         (sub)[1][(uint8_t)((w) >> 8)]++;  \
+        (sub)[2][(uint8_t)((w) >> 16)]++; (sub)[3][(uint8_t)((w) >> 24)]++; \
+        (sub)[0][(uint8_t)((w) >> 32)]++; (sub)[1][(uint8_t)((w) >> 40)]++; \
+        (sub)[2][(uint8_t)((w) >> 48)]++; (sub)[3][(uint8_t)((w) >> 56)]++; \
+} while (0)
+
+// 기본(스칼라) 커널: 8바이트씩 읽어서 보조 히스토그램에 분산
+static void histogram_scalar(const unsigned char *p, size_t n, uint32_t sub[ENTROPY_SUB_HISTOGRAMS][256]) {
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+                uint64_t w0, w1;
+                memcpy(&w0, p + i, 8);
+                memcpy(&w1, p + i + 8, 8);
+                HIST_WORD(sub, w0);
+                HIST_WORD(sub, w1);
+        }
+        for (; i < n; i++) {
+                sub[i & (ENTROPY_SUB_HISTOGRAMS - 1)][p[i]]++;
+        }
+}
+
+// 남은 바이트 처리: 히스토그램 + 이웃 바이트 곱 (i 부터 끝까지)
+static void histogram_serial_tail(const unsigned char *p, size_t i, size_t n,
+                                  uint32_t sub[ENTROPY_SUB_HISTOGRAMS][256], uint64_t *serial) {
+        uint64_t s = 0;
+        for (; i < n; i++) {
+                sub[i & (ENTROPY_SUB_HISTOGRAMS - 1)][p[i]]++;
+                if (i + 1 < n) {
+                        s += (uint32_t)p[i] * p[i + 1];
+                }
+        }
+        *serial += s;
+}
+
+// 기본(스칼라) 통합 커널: 8바이트 단어와 1바이트 밀린 단어를 같이 읽어서 곱을 누적
+static void histogram_serial_scalar(const unsigned char *p, size_t n, uint32_t sub[ENTROPY_SUB_HISTOGRAMS][256],
+                                    uint64_t *serial) {
+        uint64_t s = 0;
+        size_t i = 0;
+        for (; i + 9 <= n; i += 8) {
+                uint64_t w, w1;
+                memcpy(&w, p + i, 8);
+                memcpy(&w1, p + i + 1, 8);
+                HIST_WORD(sub, w);
+                for (int k = 0; k < 64; k += 8) {
+                        s += (uint32_t)(uint8_t)(w >> k) * (uint8_t)(w1 >> k);
+                }
+        }
+        *serial += s;
+        histogram_serial_tail(p, i, n, sub, serial);
+}
+
+#ifdef ENTROPY_HAVE_X86
+// SSE4.1 커널: 16바이트 블록이 한 가지 바이트로만 채워져 있으면(0 패딩 등) 한 번에 +16
+__attribute__((target("sse4.1")))
+static void histogram_sse41(const unsigned char *p, size_t n, uint32_t sub[ENTROPY_SUB_HISTOGRAMS][256]) {
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+                __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+                __m128i first = _mm_set1_epi8((char)p[i]);
+                if (_mm_test_all_ones(_mm_cmpeq_epi8(v, first))) {
+                        sub[0][p[i]] += 16;
+                        continue;
+                }
+                uint64_t w0 = (uint64_t)_mm_cvtsi128_si64(v);
+                uint64_t w1 = (uint64_t)_mm_extract_epi64(v, 1);
+                HIST_WORD(sub, w0);
+                HIST_WORD(sub, w1);
+        }
+        for (; i < n; i++) {
+                sub[i & (ENTROPY_SUB_HISTOGRAMS - 1)][p[i]]++;
+        }
+}
+
+// AVX2 커널: 32바이트 블록 단위로 같은 바이트 반복 구간을 건너뜀
+__attribute__((target("avx2")))
+static void histogram_avx2(const unsigned char *p, size_t n, uint32_t sub[ENTROPY_SUB_HISTOGRAMS][256]) {
+        size_t i = 0;
+        for (; i + 32 <= n; i += 32) {
+                __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+                __m256i first = _mm256_set1_epi8((char)p[i]);
+                if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, first)) == -1) {
+                        sub[0][p[i]] += 32;
+                        continue;
+                }
+                uint64_t w0 = (uint64_t)_mm256_extract_epi64(v, 0);
+                uint64_t w1 = (uint64_t)_mm256_extract_epi64(v, 1);
+                uint64_t w2 = (uint64_t)_mm256_extract_epi64(v, 2);
+                uint64_t w3 = (uint64_t)_mm256_extract_epi64(v, 3);
+                HIST_WORD(sub, w0);
+                HIST_WORD(sub, w1);
+                HIST_WORD(sub, w2);
+                HIST_WORD(sub, w3);
+        }
+        _mm256_zeroupper(); // 상위 YMM 정리: 안 하면 이후 SSE 코드(libm log2 등)가 전부 느려짐
+        histogram_scalar(p + i, n - i, sub);
+}
+
+// SSE4.1 통합 커널: 이웃 바이트 곱은 16비트로 넓혀서 pmaddwd 로 계산
+__attribute__((target("sse4.1")))
+static void histogram_serial_sse41(const unsigned char *p, size_t n, uint32_t sub[ENTROPY_SUB_HISTOGRAMS][256],
+                                   uint64_t *serial) {
+        uint64_t s = 0;
+        __m128i acc = _mm_setzero_si128();
+        size_t blocks = 0;
+        size_t i = 0;
+        for (; i + 17 <= n; i += 16) {
+                __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+                __m128i v1 = _mm_loadu_si128((const __m128i *)(p + i + 1));
+                __m128i lo = _mm_madd_epi16(_mm_cvtepu8_epi16(v), _mm_cvtepu8_epi16(v1));
+                __m128i hi = _mm_madd_epi16(_mm_cvtepu8_epi16(_mm_srli_si128(v, 8)),
+                                            _mm_cvtepu8_epi16(_mm_srli_si128(v1, 8)));
+                acc = _mm_add_epi32(acc, _mm_add_epi32(lo, hi));
+                if (++blocks == SERIAL_FLUSH_BLOCKS) {
+                        uint32_t lanes[4];
+                        _mm_storeu_si128((__m128i *)lanes, acc);
+                        s += (uint64_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+                        acc = _mm_setzero_si128();
+                        blocks = 0;
+                }
+
+                __m128i first = _mm_set1_epi8((char)p[i]);
+                if (_mm_test_all_ones(_mm_cmpeq_epi8(v, first))) {
+                        sub[0][p[i]] += 16;
+                        continue;
+                }
+                uint64_t w0 = (uint64_t)_mm_cvtsi128_si64(v);
+                uint64_t w1 = (uint64_t)_mm_extract_epi64(v, 1);
+                HIST_WORD(sub, w0);
+                HIST_WORD(sub, w1);
+        }
+        uint32_t lanes[4];
+        _mm_storeu_si128((__m128i *)lanes, acc);
+        s += (uint64_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+        *serial += s;
+        histogram_serial_tail(p, i, n, sub, serial);
+}
+
+// AVX2 통합 커널: 32바이트 단위, 이웃 바이트 곱은 vpmaddwd 두 번
+__attribute__((target("avx2")))
+static void histogram_serial_avx2(const unsigned char *p, size_t n, uint32_t sub[ENTROPY_SUB_HISTOGRAMS][256],
+                                  uint64_t *serial) {
+        uint64_t s = 0;
+        __m256i acc = _mm256_setzero_si256();
+        size_t blocks = 0;
+        size_t i = 0;
+        for (; i + 33 <= n; i += 32) {
+                __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+                __m256i v1 = _mm256_loadu_si256((const __m256i *)(p + i + 1));
+                __m256i lo = _mm256_madd_epi16(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(v)),
+                                               _mm256_cvtepu8_epi16(_mm256_castsi256_si128(v1)));
+                __m256i hi = _mm256_madd_epi16(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(v, 1)),
+                                               _mm256_cvtepu8_epi16(_mm256_extracti128_si256(v1, 1)));
+                acc = _mm256_add_epi32(acc, _mm256_add_epi32(lo, hi));
+                if (++blocks == SERIAL_FLUSH_BLOCKS) {
+                        uint32_t lanes[8];
+                        _mm256_storeu_si256((__m256i *)lanes, acc);
+                        for (int k = 0; k < 8; k++) {
+                                s += lanes[k];
+                        }
+                        acc = _mm256_setzero_si256();
+                        blocks = 0;
+                }
+
+                __m256i first = _mm256_set1_epi8((char)p[i]);
+                if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, first)) == -1) {
+                        sub[0][p[i]] += 32;
+                        continue;
+                }
+                uint64_t w0 = (uint64_t)_mm256_extract_epi64(v, 0);
+                uint64_t w1 = (uint64_t)_mm256_extract_epi64(v, 1);
+                uint64_t w2 = (uint64_t)_mm256_extract_epi64(v, 2);
+                uint64_t w3 = (uint64_t)_mm256_extract_epi64(v, 3);
+                HIST_WORD(sub, w0);
+                HIST_WORD(sub, w1);
+                HIST_WORD(sub, w2);
+                HIST_WORD(sub, w3);
+        }
+        uint32_t lanes[8];
+        _mm256_storeu_si256((__m256i *)lanes, acc);
+        for (int k = 0; k < 8; k++) {
+                s += lanes[k];
+        }
+        *serial += s;
+        _mm256_zeroupper();
+        histogram_serial_tail(p, i, n, sub, serial);
+}
+#endif
+
+// 최초 1회: c*log2(c) 테이블 생성 + CPU 기능에 맞는 커널 선택
+static void entropy_init_once(void) {
+        g_clogc[0] = 0.0;
+        for (int c = 1; c < ENTROPY_CLOGC_TABLE; c++) {
+                g_clogc[c] = (double)c * log2((double)c);
+        }
+
+        g_histogram_kernel = histogram_scalar;
+        g_serial_kernel = histogram_serial_scalar;
+#ifdef ENTROPY_HAVE_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+                g_histogram_kernel = histogram_avx2;
+                g_serial_kernel = histogram_serial_avx2;
+                g_kernel_name = "avx2";
+        } else if (__builtin_cpu_supports("sse4.1")) {
+                g_histogram_kernel = histogram_sse41;
+                g_serial_kernel = histogram_serial_sse41;
+                g_kernel_name = "sse4.1";
+        }
+#endif
+}
+
+const char *entropy_kernel_name(void) {
+        pthread_once(&g_entropy_once, entropy_init_once);
+        return g_kernel_name;
+}
+
+// 보조 히스토그램 합치기
+static void merge_sub_histograms(uint32_t sub[ENTROPY_SUB_HISTOGRAMS][256], uint64_t counts[256]) {
+        for (int b = 0; b < 256; b++) {
+                counts[b] += (uint64_t)sub[0][b] + sub[1][b] + sub[2][b] + sub[3][b];
+        }
+}
+
+// 버퍼의 바이트 빈도를 counts 에 더함 (counts 는 호출자가 0으로 초기화)
+void entropy_histogram(const char *buffer, size_t size, uint64_t counts[256]) {
+        pthread_once(&g_entropy_once, entropy_init_once);
+
+        const unsigned char *p = (const unsigned char *)buffer;
+        while (size > 0) {
+                size_t n = size < ENTROPY_SLICE ? size : ENTROPY_SLICE;
+                uint32_t sub[ENTROPY_SUB_HISTOGRAMS][256];
+                memset(sub, 0, sizeof(sub));
+
+                g_histogram_kernel(p, n, sub);
+                merge_sub_histograms(sub, counts);
+                p += n;
+                size -= n;
+        }
+}
+
+// 히스토그램과 함께 Σ x[i]*x[i+1] 을 serial_sum 에 더함 (버퍼를 한 번만 읽음)
+void entropy_histogram_serial(const char *buffer, size_t size, uint64_t counts[256], uint64_t *serial_sum) {
+        pthread_once(&g_entropy_once, entropy_init_once);
+
+        const unsigned char *p = (const unsigned char *)buffer;
+        while (size > 0) {
+                size_t n = size < ENTROPY_SLICE ? size : ENTROPY_SLICE;
+                uint32_t sub[ENTROPY_SUB_HISTOGRAMS][256];
+                memset(sub, 0, sizeof(sub));
+
+                g_serial_kernel(p, n, sub, serial_sum);
+                merge_sub_histograms(sub, counts);
+                if (n < size) {
+                        *serial_sum += (uint64_t)p[n - 1] * p[n]; // 나눠진 구간 경계의 이웃 쌍
+                }
+                p += n;
+                size -= n;
+        }
+}
+
+static inline double clogc(uint64_t c) {
+        if (c < ENTROPY_CLOGC_TABLE) {
+                return g_clogc[c];
+        }
+        return (double)c * log2((double)c);
+}
+
+/* 빈도표로 엔트로피 계산
+ * H = -Σ p*log2(p), p = c/N 을 정리하면 H = log2(N) - (Σ c*log2(c)) / N
+ * -> 바이트값마다 log2() 를 부르는 대신 c*log2(c) 테이블을 조회함 */
+double entropy_from_counts(const uint64_t counts[256], uint64_t total) {
+        if (total == 0) {
+                return 0.0;
+        }
+        pthread_once(&g_entropy_once, entropy_init_once);
+
+        double sum = 0.0;
+        for (int i = 0; i < 256; i++) {
+                sum += clogc(counts[i]); // 한 번도 안 나온 바이트는 0*log2(0) = 0
+        }
+        double entropy = log2((double)total) - sum / (double)total;
+        return entropy > 0.0 ? entropy : 0.0; // 반올림 오차로 -0.0 이 나오는 경우 방지
+}
 
 double calculate_entropy(const char *buffer, size_t size){
         if (size == 0) { // 데이터의 크기가 0이면 계산 안하기
                 return 0.0;
         }
 
-        long long counts[256]; //0~255 까지 256 개의 값이 각각 몇 번 등장했는지 저장하는 배열
-        memset(counts, 0, sizeof(counts)); //mamset() 는 배열 256 개의 칸을 0으로 초기화하는 것
+        uint64_t counts[256]; //0~255 까지 256 개의 값이 각각 몇 번 등장했는지 저장하는 배열
+        memset(counts, 0, sizeof(counts));
+
+        entropy_histogram(buffer, size, counts);
+        return entropy_from_counts(counts, size);
+}
+/* 빈도표 + 이웃 바이트 곱의 합으로 무작위성 통계 계산 (버퍼를 다시 읽지 않음)
+ * - 카이제곱: 균등분포(각 바이트 N/256 번)와의 차이, 무작위면 자유도 255 근처
+ * - 평균: Σ b*c / N, 무작위면 127.5
+ * - 상관계수: (N Σ x[i]x[i+1] - (Σx)^2) / (N Σx^2 - (Σx)^2), 무작위면 0 근처 */
+void randomness_from_counts(const uint64_t counts[256], uint64_t total, uint64_t serial_sum,
+                            RandomnessStats *stats) {
+        memset(stats, 0, sizeof(*stats));
+        if (total == 0) {
+                return;
+        }
+
+        double expected = (double)total / 256.0;
+        double chi_square = 0.0;
+        double sum = 0.0;       // Σx
+        double sum_sq = 0.0;    // Σx^2
+        for (int b = 0; b < 256; b++) {
+                double c = (double)counts[b];
+                double diff = c - expected;
+                chi_square += diff * diff;
+                sum += c * b;
+                sum_sq += c * b * b;
+        }
+
+        double n = (double)total;
+        stats->entropy = entropy_from_counts(counts, total);
+        stats->chi_square = chi_square / expected;
+        stats->mean = sum / n;
 
-        for (size_t i =0; i<size; i++){ // 0번째부터 (size-1) 바이트까지 하나씩 순회
-                counts[(unsigned char) buffer[i]]++; //unsigned로 음수값은 저장안되게
-        } //예) i =65('A') 이면 counts[65] 의 값을 +1하는 것임
+        double denominator = n * sum_sq - sum * sum;
+        if (denominator == 0.0) {
+                stats->serial_correlation = 1.0; // 전부 같은 바이트면 완전 상관
+        } else {
+                stats->serial_correlation = (n * (double)serial_sum - sum * sum) / denominator;
+        }
+}
 
-        double entropy = 0.0; //엔트로피 값을 누적하는 변수 선언
+// 버퍼 한 번 순회로 엔트로피, 카이제곱, 평균, 이웃 바이트 상관계수를 모두 계산
+void calculate_randomness(const char *buffer, size_t size, RandomnessStats *stats) {
+        uint64_t counts[256];
+        uint64_t serial_sum = 0;
+        memset(counts, 0, sizeof(counts));
 
-        for (int i = 0; i < 256; i++){
-                if (counts[i] == 0){//바이트값이 데이터에 한 번도 등장하지 않으면 확률p =0 == 연산 안 함
+        if (size > 0) {
+                entropy_histogram_serial(buffer, size, counts, &serial_sum);
+                // 마지막 바이트와 첫 바이트도 이웃으로 봄 (ent 와 같은 방식)
+                serial_sum += (uint64_t)(unsigned char)buffer[size - 1] * (unsigned char)buffer[0];
+        }
+        randomness_from_counts(counts, size, serial_sum, stats);
+}
+
+void entropy_state_init(EntropyState *state) {
+        memset(state, 0, sizeof(*state));
+}
+
+// 청크 빈도표를 누적: 청크에 나온 바이트 칸만 c*log2(c) 차이를 반영
+void entropy_state_add(EntropyState *state, const uint64_t counts[256], uint64_t n) {
+        pthread_once(&g_entropy_once, entropy_init_once);
+        for (int i = 0; i < 256; i++) {
+                if (counts[i] == 0) {
                         continue;
                 }
+                uint64_t before = state->counts[i];
+                state->counts[i] = before + counts[i];
+                state->sum_clogc += clogc(state->counts[i]) - clogc(before);
+        }
+        state->total += n;
+}
 
-                double probability = (double)counts[i] / size; /*  왜 size로 나누는가?
-
-counts[i]는 버퍼 안에서 특정 바이트 값이 등장한 횟수
-예:
+double entropy_state_value(const EntropyState *state) {
+        if (state->total == 0) {
+                return 0.0;
+        }
+        double entropy = log2((double)state->total) - state->sum_clogc / (double)state->total;
+        return entropy > 0.0 ? entropy : 0.0;
+}
 
-전체 데이터 크기 = 1000바이트
+// 표본 위치를 무작위로 고를 때 쓰는 난수 (xorshift64*)
+static uint64_t sample_next(uint64_t *state) {
+        uint64_t x = *state;
+        x ^= x >> 12;
+        x ^= x << 25;
+        x ^= x >> 27;
+        *state = x;
+        return x * 0x2545F4914F6CDD1DULL;
+}
 
-0x41('A') 바이트가 50번 등장
+/* 버퍼를 blocks 개 구간으로 나누고 구간마다 block_size 바이트씩만 히스토그램에 누적
+ * seed == 0 이면 각 구간의 맨 앞(균등 간격), 아니면 구간 안에서 무작위 위치를 고름
+ * serial_sum 이 NULL 이 아니면 블록 안의 이웃 바이트 곱도 같이 누적
+ * 반환값: 실제로 읽은(표본) 바이트 수 */
+size_t entropy_sample_histogram(const char *buffer, size_t size, size_t blocks, size_t block_size,
+                                uint64_t seed, uint64_t counts[256], uint64_t *serial_sum) {
+        if (blocks == 0 || block_size == 0 || blocks * block_size >= size ||
+            blocks * block_size >= ENTROPY_SLICE) {
+                // 표본이 버퍼보다 크면 그냥 전체 검사
+                if (serial_sum != NULL) {
+                        entropy_histogram_serial(buffer, size, counts, serial_sum);
+                } else {
+                        entropy_histogram(buffer, size, counts);
+                }
+                return size;
+        }
+        pthread_once(&g_entropy_once, entropy_init_once);
 
-그러면 'A'가 등장할 확률은:
-𝑝(′𝐴′)=50/1000=0.05
+        // 블록마다 보조 히스토그램을 새로 만들지 않고 한 번에 모아서 합침
+        uint32_t sub[ENTROPY_SUB_HISTOGRAMS][256];
+        memset(sub, 0, sizeof(sub));
 
-즉 전체 데이터 중에서 해당 바이트가 차지하는 비율을 구하는 것이기 때문에 총 데이터 크기인 size로 나눠주는 것
-*/
+        const unsigned char *p = (const unsigned char *)buffer;
+        size_t stride = size / blocks; // 구간 하나의 크기 (>= block_size)
+        for (size_t i = 0; i < blocks; i++) {
+                size_t start = i * stride;
+                if (seed != 0 && stride > block_size) {
+                        start += sample_next(&seed) % (stride - block_size + 1);
+                }
+                if (serial_sum != NULL) {
+                        g_serial_kernel(p + start, block_size, sub, serial_sum);
+                } else {
+                        g_histogram_kernel(p + start, block_size, sub);
+                }
+        }
+        merge_sub_histograms(sub, counts);
+        return blocks * block_size;
+}
 
-                entropy -= probability * log2(probability); //엔트로피 공식에 의해 각 바이트를 누적한 최종 엔트로피 계산
+/* 표본 엔트로피의 오차 한계 (bit)
+ * - 편향: 표본이 작으면 엔트로피가 작게 나옴 -> Miller-Madow 보정값 (K-1) / (2m ln2)
+ * - 분산: Var[-log2 p] / m 의 표준편차 3배 (약 99.7%)
+ * 블록 단위 표본이라 바이트들이 완전히 독립은 아니므로 근사치임 */
+double entropy_error_bound(const uint64_t counts[256], uint64_t total) {
+        if (total == 0) {
+                return 8.0;
+        }
+        double entropy = entropy_from_counts(counts, total);
+        double second = 0.0; // Σ p * (log2 p)^2
+        int nonzero = 0;
+        for (int i = 0; i < 256; i++) {
+                if (counts[i] == 0) {
+                        continue;
+                }
+                double p = (double)counts[i] / (double)total;
+                double l = log2(p);
+                second += p * l * l;
+                nonzero++;
+        }
+        double variance = second - entropy * entropy;
+        if (variance < 0.0) {
+                variance = 0.0;
         }
-        return entropy;
+        double bias = (double)(nonzero - 1) / (2.0 * (double)total * M_LN2);
+        return bias + 3.0 * sqrt(variance / (double)total);
 }
+
 /*만약 데이터가 'A'로만 가득 차 있다면 (예: "AAAAA"):
      * P('A') = 1.0, P(나머지) = 0.
      * entropy = - (1.0 * log2(1.0)) = - (1.0 * 0) = 0.0 */
-/* 동일한 문자가 반복되면 엔트로피 낮아지는 저엔트로피 우회방법을 red 팀이 사용가능함 -> 막는 방법도 추가로 고려해봐야함
+/* 동일한 문자가 반복되면 엔트로피 낮아지는 저엔트로피 우회방법을 red 팀이 사용가능함 -> 막는 방법도 추가로 고려해봐야함 */
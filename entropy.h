@@ -1,5 +1,35 @@
 #ifndef ENTROPY_H
 #define ENTROPY_H
 #include <stddef.h>
+#include <stdint.h>
 double calculate_entropy(const char*buffer, size_t size);
+void entropy_histogram(const char *buffer, size_t size, uint64_t counts[256]); // counts 에 바이트 빈도 누적
+double entropy_from_counts(const uint64_t counts[256], uint64_t total); // 빈도표 -> 엔트로피
+void entropy_histogram_serial(const char *buffer, size_t size, uint64_t counts[256],
+                              uint64_t *serial_sum); // 히스토그램 + Σ x[i]*x[i+1] 한 번에
+size_t entropy_sample_histogram(const char *buffer, size_t size, size_t blocks, size_t block_size,
+                                uint64_t seed, uint64_t counts[256],
+                                uint64_t *serial_sum); // 블록 표본만 누적 (serial_sum 은 NULL 가능)
+double entropy_error_bound(const uint64_t counts[256], uint64_t total); // 표본 엔트로피 오차 한계
+// 한 번 순회로 구하는 무작위성 통계 (엔트로피 하나만으로는 우회가 쉬워서 같이 봄)
+typedef struct {
+        double entropy;            // 섀넌 엔트로피 (bit/byte)
+        double chi_square;         // 균등분포 대비 카이제곱 (자유도 255)
+        double mean;               // 바이트 산술 평균 (무작위면 127.5)
+        double serial_correlation; // 이웃 바이트 상관계수 (무작위면 0 근처)
+} RandomnessStats;
+void calculate_randomness(const char *buffer, size_t size, RandomnessStats *stats);
+void randomness_from_counts(const uint64_t counts[256], uint64_t total, uint64_t serial_sum,
+                            RandomnessStats *stats);
+
+// 파일 하나의 누적 엔트로피 상태 (순차 write 를 이어서 하나의 데이터로 봄)
+typedef struct {
+        uint64_t counts[256];
+        uint64_t total;
+        double sum_clogc; // Σ c*log2(c), 바뀐 칸만 갱신해서 엔트로피를 O(1) 로 계산
+} EntropyState;
+void entropy_state_init(EntropyState *state);
+void entropy_state_add(EntropyState *state, const uint64_t counts[256], uint64_t n); // 청크 빈도표 누적
+double entropy_state_value(const EntropyState *state); // 누적 엔트로피 (O(1))
+const char *entropy_kernel_name(void); // 선택된 히스토그램 커널 ("avx2", "sse4.1", "scalar")
 #endif
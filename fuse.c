@@ -1,5 +1,4 @@
 #define FUSE_USE_VERSION 35
-#define MAX_TRACKED_PIDS 100
 #include <fuse3/fuse.h>
 #include <stdio.h>
 #include <stdlib.h>     // realpath 함수 사용을 위해 추가
@@ -13,78 +12,12 @@
 #include <sys/time.h>
 #include <signal.h>
 #include <sys/types.h>
+#include "score_table.h"
 #include "analyzer.h" // (재린 추가함) 스코어 계산하는 함수
 #define KILL_THRESHOLD 80    // Malice Score 강제 종료 임계값 ((임시))
 
 static int base_fd = -1;
 
-
-// PID별 Malice Score, 행동 정보 저장할 구조체
-typedef struct {
-    pid_t pid;             
-    int malice_score;      
-    time_t last_write_time; // 마지막 쓰기 연산 시간 
-    char proc_name[32];  //  프로세스 이름 저장
-} ProcessScore;
-
-// 전역 Score 테이블
-ProcessScore g_score_table[MAX_TRACKED_PIDS];
-int g_process_count = 0; // 현재 추적 중인 프로세스 개수
-
-// ProcessScore 엔트리를 찾거나 새로 생성해 포인터 반환
-ProcessScore* find_or_create_score_entry(pid_t pid) {
-    // 기존 엔트리 검색
-    for (int i = 0; i < g_process_count; i++) {
-        if (g_score_table[i].pid == pid) {
-            // PID가 이미 존재하면 해당 엔트리 반환
-            return &g_score_table[i];
-	}
-    }
-    
-    // 새 엔트리 생성
-    if (g_process_count < MAX_TRACKED_PIDS) {
-        ProcessScore *new_entry = &g_score_table[g_process_count];
-        // 새로운 엔트리 초기화
-        new_entry->pid = pid;
-        new_entry->malice_score = 0;
-        new_entry->last_write_time = time(NULL);
-        g_process_count++; // 추적 중인 프로세스 수 증가
-        
-        return new_entry;
-    }
-    
-    // 배열이 가득 찼을 때 
-    fprintf(stderr, "오류: 최대 PID 추적 개수 초과!\n");
-    return NULL;
-}
-
-// 특정 PID의 Malice Score 업데이트, 마지막 쓰기 시간 갱신
-void update_malice_score(pid_t pid, int added_score) {
-    ProcessScore *entry = find_or_create_score_entry(pid);
-    
-    if (entry) {
-        entry->malice_score += added_score;
-        entry->last_write_time = time(NULL); 
-    }
-}
-
-// 특정 PID의 Malice Score 반환
-int get_malice_score(pid_t pid) {
-    ProcessScore *entry = find_or_create_score_entry(pid);
-    if (entry) {
-        return entry->malice_score;
-    }
-    return 0; // 엔트리 못 찾으면 0점 반환
-}
-
-// 프로세스 종료 시 Score 0으로 초기화
-void reset_malice_score(pid_t pid) {
-    ProcessScore *entry = find_or_create_score_entry(pid);
-    if (entry) {
-        entry->malice_score = 0;
-    }
-}
-
 static void get_relative_path(const char *path, char *relpath) {
     if (strcmp(path, "/") == 0 || strcmp(path, "") == 0) {
         strcpy(relpath, ".");
@@ -195,14 +128,11 @@ static int myfs_write(const char *path, const char *buf, size_t size, off_t offs
     struct fuse_context *context = fuse_get_context();
     pid_t current_pid = context->pid;
     
-    // Score 계산 및 갱신 -> (수정사항: get_score() 함수 사용함
-    int added_score = get_score("WRITE", buf, size);
+    // Score 계산 및 갱신 -> (수정사항: monitor_event() 함수 사용함
+    AnalyzerEvent ev = { .op = ANALYZER_OP_WRITE, .pid = current_pid, .offset = offset, .size = size, .buf = buf };
 
-    update_malice_score(current_pid, added_score);
-    
-    
     // 임계값 확인 후 강제 종료 조치
-    if (get_malice_score(current_pid) >= KILL_THRESHOLD) {
+    if (monitor_event(&ev) >= KILL_THRESHOLD) {
         fprintf(stderr, "Kill ! 'write' 임계값 초과! PID %d 강제 종료\n", current_pid);
         
         // 강제 종료 실행
@@ -226,10 +156,7 @@ static int myfs_write(const char *path, const char *buf, size_t size, off_t offs
 // release 함수 구현
 static int myfs_release(const char *path, struct fuse_file_info *fi) {
     close(fi->fh);
-    struct fuse_context *context = fuse_get_context();
-    pid_t current_pid = context->pid;
-
-    reset_malice_score(current_pid); //파일 닫으면 해당 p의 score초기화
+    // 점수는 닫을 때 지우지 않음 (열고 닫기 반복으로 우회 가능) -> 반감기로 줄어듦
     return 0;
 }
 
@@ -238,10 +165,8 @@ static int myfs_unlink(const char *path) {
     struct fuse_context *context = fuse_get_context(); //(새로추가) -> PID 획득
     pid_t current_pid = context->pid;
     
-    int added_score = get_score("UNLINK", NULL, 0); //(새로추가) -> score 계산 (buf/size 가 없으므로 NULL,0 을 전달)
-    update_malice_score(current_pid, added_score); //(새로추가) -> 추가하기
-   
-    if(get_malice_score(current_pid) >= KILL_THRESHOLD) {//(if 문 전체 새로 추가)
+    AnalyzerEvent ev = { .op = ANALYZER_OP_UNLINK, .pid = current_pid };
+    if(monitor_event(&ev) >= KILL_THRESHOLD) {//점수 + 빈도 벌점 추가, 임계값 확인 한 번에
 	    fprintf(stderr, "Kill ! 'unlink' 임계값 초과! PID %d 강제종료\n", current_pid);
 	    if(kill(current_pid,SIGKILL) == -1){
 		    fprintf(stderr, " 킬명령어 실패:%s\n", strerror(errno));
@@ -290,10 +215,8 @@ static int myfs_rename(const char *from, const char *to, unsigned int flags) {
     struct fuse_context *context = fuse_get_context(); //(새로추가) -> PID 획득
     pid_t current_pid = context->pid;
 
-    int added_score = get_score("RENAME", NULL, 0); //(새로추가) -> score 계산 (buf/size 가 없으므로 NULL,0 을 전달)
-    update_malice_score(current_pid, added_score); //(새로추가) -> 추가하기
-
-    if(get_malice_score(current_pid) >= KILL_THRESHOLD) {//(if 문 전체 새로 추가)
+    AnalyzerEvent ev = { .op = ANALYZER_OP_RENAME, .pid = current_pid };
+    if(monitor_event(&ev) >= KILL_THRESHOLD) {//점수 + 빈도 벌점 추가, 임계값 확인 한 번에
             fprintf(stderr, "Kill ! 'rename' 임계값 초과! PID %d 강제종료\n", current_pid);
             if(kill(current_pid,SIGKILL) == -1){
                     fprintf(stderr, " 킬명령어 실패:%s\n", strerror(errno));
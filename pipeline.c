@@ -0,0 +1,242 @@
+#include "pipeline.h"
+#include "analyzer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+#define PIPELINE_SAMPLE_BLOCKS 16 // 큰 write 는 16개 블록만 복사 (16 x 4KB = PIPELINE_DATA_MAX)
+
+/* 워커 하나가 가진 링 (여러 FUSE 스레드가 넣고 워커 하나만 꺼내는 MPSC)
+ 칸마다 순번(seq)을 두어 락 없이 넣고 꺼냄:
+ - seq == pos       : 비어 있음, 생산자가 pos 를 CAS 로 차지
+ - seq == pos + 1   : 데이터 준비됨, 소비자가 꺼냄
+ - 꺼낸 뒤 seq = pos + capacity (다음 바퀴용) */
+typedef struct {
+    _Atomic size_t seq;
+    PipelineEvent ev;
+} RingCell;
+
+typedef struct {
+    RingCell *cells;
+    size_t mask;
+    _Atomic size_t enqueue_pos;
+    _Atomic size_t dequeue_pos;
+    sem_t ready;                // 링에 넣은 이벤트 수 (워커 대기용)
+    pthread_t thread;
+} Ring;
+
+static Ring *g_rings = NULL;
+static unsigned g_ring_count = 0;
+static pipeline_handler_t g_handler = NULL;
+static atomic_int g_running = 0;
+static _Atomic uint64_t g_drops = 0;
+static _Atomic uint64_t g_processed = 0;
+
+// 경로 해시 (FNV-1a)
+static uint64_t path_hash(const char *path) {
+    uint64_t h = 1469598103934665603ULL;
+    for (const unsigned char *p = (const unsigned char *)path; *p; p++) {
+        h ^= *p;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// 이벤트 내용 채우기: 버퍼가 크면 균등 간격 블록만 복사 (analyzer 의 표본 모드와 같은 방식)
+static void fill_event(PipelineEvent *ev, pid_t pid, int op, uint64_t path_id, const char *path,
+                       const char *buf, size_t size, off_t offset, void *ctx) {
+    ev->pid = pid;
+    ev->op = op;
+    ev->path_id = path_id;
+    strncpy(ev->path, path, PATH_MAX - 1);
+    ev->path[PATH_MAX - 1] = '\0';
+    ev->offset = offset;
+    ev->size = size;
+    ev->ctx = ctx;
+    ev->time_ms = analyzer_now_ms();
+
+    if (buf == NULL || size == 0) {
+        ev->data_len = 0;
+    } else if (size <= PIPELINE_DATA_MAX) {
+        memcpy(ev->data, buf, size);
+        ev->data_len = size;
+    } else {
+        size_t block = PIPELINE_DATA_MAX / PIPELINE_SAMPLE_BLOCKS;
+        size_t stride = size / PIPELINE_SAMPLE_BLOCKS;
+        for (size_t i = 0; i < PIPELINE_SAMPLE_BLOCKS; i++) {
+            memcpy(ev->data + i * block, buf + i * stride, block);
+        }
+        ev->data_len = PIPELINE_DATA_MAX;
+    }
+}
+
+// 워커 스레드: 자기 링에서 하나씩 꺼내 handler 호출
+static void *pipeline_worker(void *arg) {
+    Ring *ring = arg;
+
+    for (;;) {
+        while (sem_wait(&ring->ready) == -1 && errno == EINTR) {
+        }
+        size_t pos = atomic_load_explicit(&ring->dequeue_pos, memory_order_relaxed);
+        RingCell *cell = &ring->cells[pos & ring->mask];
+
+        // 생산자가 칸을 차지했지만 아직 다 못 쓴 경우 잠깐 대기
+        while (atomic_load_explicit(&cell->seq, memory_order_acquire) != pos + 1) {
+            if (!atomic_load(&g_running)) {
+                return NULL;
+            }
+            sched_yield();
+        }
+        if (cell->ev.op < 0) { // pipeline_stop 이 넣은 종료 이벤트
+            return NULL;
+        }
+
+        g_handler(&cell->ev);
+        atomic_fetch_add_explicit(&g_processed, 1, memory_order_relaxed);
+
+        atomic_store_explicit(&cell->seq, pos + ring->mask + 1, memory_order_release);
+        atomic_store_explicit(&ring->dequeue_pos, pos + 1, memory_order_relaxed);
+    }
+}
+
+// 링에 칸 하나 차지 (가득 차면 NULL)
+static RingCell *ring_claim(Ring *ring, size_t *pos_out) {
+    size_t pos = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+    for (;;) {
+        RingCell *cell = &ring->cells[pos & ring->mask];
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+        if (dif == 0) {
+            if (atomic_compare_exchange_weak_explicit(&ring->enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                *pos_out = pos;
+                return cell;
+            }
+        } else if (dif < 0) {
+            return NULL; // 가득 참
+        } else {
+            pos = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+        }
+    }
+}
+
+int pipeline_start(unsigned workers, unsigned capacity, pipeline_handler_t handler) {
+    if (workers == 0 || handler == NULL) {
+        return -1;
+    }
+    size_t cap = 2;
+    while (cap < capacity) {
+        cap <<= 1;
+    }
+
+    g_rings = calloc(workers, sizeof(Ring));
+    if (g_rings == NULL) {
+        return -1;
+    }
+    g_handler = handler;
+    atomic_store(&g_running, 1);
+
+    for (unsigned i = 0; i < workers; i++) {
+        Ring *ring = &g_rings[i];
+        ring->cells = malloc(cap * sizeof(RingCell));
+        if (ring->cells == NULL) {
+            fprintf(stderr, "PIPELINE: 링 메모리 할당 실패\n");
+            pipeline_stop();
+            return -1;
+        }
+        for (size_t c = 0; c < cap; c++) {
+            atomic_init(&ring->cells[c].seq, c);
+        }
+        ring->mask = cap - 1;
+        atomic_init(&ring->enqueue_pos, 0);
+        atomic_init(&ring->dequeue_pos, 0);
+        sem_init(&ring->ready, 0, 0);
+
+        if (pthread_create(&ring->thread, NULL, pipeline_worker, ring) != 0) {
+            fprintf(stderr, "PIPELINE: 워커 스레드 생성 실패\n");
+            free(ring->cells);
+            ring->cells = NULL;
+            pipeline_stop();
+            return -1;
+        }
+        g_ring_count++;
+    }
+
+    fprintf(stderr, "PIPELINE: 분석 워커 %u개 시작 (링 %zu칸)\n", workers, cap);
+    return 0;
+}
+
+void pipeline_stop(void) {
+    // 워커마다 종료 이벤트를 넣어서 남은 이벤트를 다 처리한 뒤 끝나게 함
+    for (unsigned i = 0; i < g_ring_count; i++) {
+        Ring *ring = &g_rings[i];
+        size_t pos;
+        RingCell *cell;
+        while ((cell = ring_claim(ring, &pos)) == NULL) {
+            sched_yield();
+        }
+        cell->ev.op = -1;
+        atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+        sem_post(&ring->ready);
+    }
+    for (unsigned i = 0; i < g_ring_count; i++) {
+        pthread_join(g_rings[i].thread, NULL);
+        sem_destroy(&g_rings[i].ready);
+        free(g_rings[i].cells);
+    }
+    atomic_store(&g_running, 0);
+    free(g_rings);
+    g_rings = NULL;
+    g_ring_count = 0;
+}
+
+int pipeline_submit(pid_t pid, int op, const char *path, const char *buf, size_t size, off_t offset, void *ctx) {
+    uint64_t path_id = path_hash(path);
+
+    if (g_ring_count > 0) {
+        Ring *ring = &g_rings[path_id % g_ring_count];
+        size_t pos;
+        RingCell *cell = ring_claim(ring, &pos);
+        if (cell != NULL) {
+            fill_event(&cell->ev, pid, op, path_id, path, buf, size, offset, ctx);
+            atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+            sem_post(&ring->ready);
+            return 0;
+        }
+    }
+
+    if (g_handler == NULL) {
+        return -1; // pipeline_start 전
+    }
+
+    // 링이 가득 참 -> 이벤트를 버리지 않고 이 스레드에서 바로 처리 (탐지 누락 방지)
+    // 스택에 둠: 할당 실패로 handler 를 건너뛰면 ctx 참조가 풀리지 않음 (~70KB, 스레드 스택 8MB 기준 충분)
+    atomic_fetch_add_explicit(&g_drops, 1, memory_order_relaxed);
+    PipelineEvent ev;
+    fill_event(&ev, pid, op, path_id, path, buf, size, offset, ctx);
+    g_handler(&ev);
+    return 1;
+}
+
+void pipeline_stats(uint64_t *depth, uint64_t *drops, uint64_t *processed) {
+    uint64_t total = 0;
+    for (unsigned i = 0; i < g_ring_count; i++) {
+        size_t in = atomic_load_explicit(&g_rings[i].enqueue_pos, memory_order_relaxed);
+        size_t out = atomic_load_explicit(&g_rings[i].dequeue_pos, memory_order_relaxed);
+        total += in - out;
+    }
+    if (depth) {
+        *depth = total;
+    }
+    if (drops) {
+        *drops = atomic_load_explicit(&g_drops, memory_order_relaxed);
+    }
+    if (processed) {
+        *processed = atomic_load_explicit(&g_processed, memory_order_relaxed);
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <limits.h>
+#include <sys/types.h>
+
+/* 비동기 점수 계산 파이프라인
+ FUSE 스레드는 이벤트만 링에 넣고 바로 pwrite 로 진행,
+ 분석 워커 스레드가 점수 계산/프로세스 상태 갱신/kill 판단을 맡음 */
+
+#define PIPELINE_DATA_MAX 65536 // 이벤트 하나에 복사해두는 최대 바이트 (더 크면 균등 간격 블록만 복사)
+
+enum { PIPE_OP_WRITE, PIPE_OP_UNLINK, PIPE_OP_RENAME }; // ANALYZER_OP_* 와 같은 순서
+
+typedef struct {
+    pid_t pid;
+    int op;                     // PIPE_OP_*
+    uint64_t path_id;           // 경로 해시 (같은 파일은 같은 워커로 -> 순서 보장)
+    char path[PATH_MAX];        // 롤백할 경로
+    off_t offset;               // write 위치
+    size_t size;                // 원래 write 크기
+    size_t data_len;            // data 에 복사된 바이트 수 (size 보다 작으면 표본)
+    uint64_t time_ms;           // 제출 시각 (analyzer_now_ms, 빈도 계산은 큐 대기 시간과 무관하게 이 값 기준)
+    void *ctx;                  // 호출자 데이터 (열린 파일 핸들 등)
+    char data[PIPELINE_DATA_MAX];
+} PipelineEvent;
+
+typedef void (*pipeline_handler_t)(const PipelineEvent *ev);
+
+/* 워커 workers 개 시작, 워커마다 capacity 칸짜리 링 (2의 거듭제곱으로 올림)
+ - handler: 워커 스레드에서 이벤트마다 호출 */
+int pipeline_start(unsigned workers, unsigned capacity, pipeline_handler_t handler);
+void pipeline_stop(void);
+
+/* 이벤트 제출. 링이 가득 차면 호출한 스레드에서 바로 handler 실행 (드롭 카운트 증가)
+ - 반환: 0 = 링에 들어감, 1 = 가득 차서 직접 처리함, -1 = 파이프라인 시작 안 됨 */
+int pipeline_submit(pid_t pid, int op, const char *path, const char *buf, size_t size, off_t offset, void *ctx);
+
+// 링에 쌓인 이벤트 수, 가득 차서 직접 처리한 수, 워커가 처리한 수
+void pipeline_stats(uint64_t *depth, uint64_t *drops, uint64_t *processed);
+
+#endif
@@ -1,4 +1,10 @@
+#define _GNU_SOURCE // copy_file_range
 #include "restore.h"
+#include "backend_io.h"
+#include "chunk_store.h"
+#include "backup_codec.h"
+#include "backup_versions.h"
+#include "backup_journal.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -9,9 +15,257 @@
 #include <fcntl.h>
 #include <string.h>
 #include <sys/time.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <linux/fs.h> // FICLONE, FS_IOC_GETVERSION
+#include <dirent.h>
+#include <pthread.h>
+#include <stdint.h>
 
 //백업dir 절대 주소(restore_init이 생성한) 저장
 static char g_backup_dir[PATH_MAX] = {0};
+static int g_dedup = 0; // 전체 복사본 대신 청크 저장소 (chunk_store.c) 사용
+static int g_compress = 0; // 복사 백업본을 압축 (backup_codec.c)
+static int g_versions = 0; // 쓰기 세션마다 새 버전 (backup_versions.c)
+static uint64_t g_version_quota = 0;
+static unsigned g_version_max_age = 0;
+static int g_quarantine = 0; // 삭제/덮어쓰기 직전 파일을 버전 저장소로 격리
+static unsigned g_quarantine_age = 0;
+static int g_version_store = 0; // 버전 저장소 열림 (버전 백업 또는 격리)
+static int g_journal = 1; // 이름/inode 백업 상태를 저널에 기록 (backup_journal.c, 임시 파일에 복사 후 link)
+
+static int copy_file_data(int src_fd, int dest_fd, const char **method);
+static int backup_copy(int src_fd, int dest_fd, const char **method);
+static int restore_copy(int src_fd, int dest_fd, const char **method);
+
+/* 백업된 파일 색인 (dev, ino, generation, 백업 방식, 이름 백업은 경로 해시)
+ write 마다 백업 디렉터리를 stat 하던 것을 메모리 조회로 바꿈 (조회가 대부분이라 샤드별 rwlock)
+ - 이름 백업(<백업dir>/<파일명>)과 inode 백업(ino-<dev>-<ino>)은 복구 방법이 달라서 따로 기록
+ - 이름 백업은 경로로 찾으므로 경로도 키에 넣음 (rename 된 파일은 새 이름으로 다시 백업)
+ - gen 0 = 모름 (파일시스템이 generation 을 안 줌, 시작 시 inode 백업 이름에서 읽은 항목) -> 아무 gen 과 일치
+ - 지우지 않음 (백업 파일도 지우지 않으므로) */
+enum { BACKUP_BY_NAME, BACKUP_BY_INODE };
+
+#define INDEX_SHARDS 16
+#define INDEX_SHARD_INITIAL 64
+
+typedef struct {
+    dev_t dev;
+    ino_t ino;
+    uint32_t gen;
+    uint8_t kind;
+    uint8_t used;
+    uint64_t name;  // 이름 백업: index_name(경로), inode 백업: 0
+} IndexEntry;
+
+typedef struct {
+    pthread_rwlock_t lock;
+    IndexEntry *slots;
+    size_t cap;     // 2의 거듭제곱
+    size_t count;
+} IndexShard;
+
+static IndexShard g_index[INDEX_SHARDS];
+static pthread_once_t g_index_once = PTHREAD_ONCE_INIT;
+
+static void backup_index_init_once(void) {
+    for (int i = 0; i < INDEX_SHARDS; i++) {
+        pthread_rwlock_init(&g_index[i].lock, NULL);
+    }
+}
+
+static uint64_t index_hash(dev_t dev, ino_t ino, int kind) {
+    uint64_t h = (uint64_t)ino * 0x9e3779b97f4a7c15ULL ^ (uint64_t)dev * 0xc2b2ae3d27d4eb4fULL ^ (uint64_t)kind;
+    return h ^ (h >> 29);
+}
+
+// 이름 백업 색인 키의 경로 해시 (FNV-1a, 앞의 '/' 무시)
+static uint64_t index_name(const char *path) {
+    uint64_t h = 1469598103934665603ULL;
+    for (const unsigned char *p = (const unsigned char *)(path[0] == '/' ? path + 1 : path); *p; p++) {
+        h ^= *p;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static int index_match(const IndexEntry *e, const BackupId *id, int kind, uint64_t name) {
+    return e->dev == id->dev && e->ino == id->ino && e->kind == kind && e->name == name &&
+           (e->gen == id->gen || e->gen == 0 || id->gen == 0);
+}
+
+// 샤드 락을 잡은 상태에서 호출
+static IndexEntry *index_probe(IndexShard *shard, uint64_t h, const BackupId *id, int kind, uint64_t name) {
+    size_t mask = shard->cap - 1;
+    for (size_t i = (h >> 4) & mask;; i = (i + 1) & mask) {
+        IndexEntry *e = &shard->slots[i];
+        if (!e->used || index_match(e, id, kind, name)) {
+            return e;
+        }
+    }
+}
+
+static int backup_index_contains(const BackupId *id, int kind, uint64_t name) {
+    pthread_once(&g_index_once, backup_index_init_once);
+    uint64_t h = index_hash(id->dev, id->ino, kind);
+    IndexShard *shard = &g_index[h & (INDEX_SHARDS - 1)];
+    pthread_rwlock_rdlock(&shard->lock);
+    int found = shard->cap > 0 && index_probe(shard, h, id, kind, name)->used;
+    pthread_rwlock_unlock(&shard->lock);
+    if (!found && g_journal) {
+        // 마지막 체크포인트까지의 항목은 저널 스냅샷 (mmap) 에만 있음
+        JournalEntry e = { .dev = id->dev, .ino = id->ino, .gen = id->gen, .kind = kind, .name = name };
+        found = journal_contains(&e);
+    }
+    return found;
+}
+
+static void backup_index_add(const BackupId *id, int kind, uint64_t name) {
+    pthread_once(&g_index_once, backup_index_init_once);
+    uint64_t h = index_hash(id->dev, id->ino, kind);
+    IndexShard *shard = &g_index[h & (INDEX_SHARDS - 1)];
+    pthread_rwlock_wrlock(&shard->lock);
+
+    // 부하율 3/4 넘으면 2배로 (지우는 일이 없으므로 그냥 다시 넣음)
+    if ((shard->count + 1) * 4 > shard->cap * 3) {
+        size_t cap = shard->cap ? shard->cap * 2 : INDEX_SHARD_INITIAL;
+        IndexEntry *slots = calloc(cap, sizeof(IndexEntry));
+        if (slots == NULL) {
+            pthread_rwlock_unlock(&shard->lock);
+            return; // 색인에 못 넣어도 다음 write 가 O_EXCL 로 다시 확인하므로 안전
+        }
+        IndexEntry *old = shard->slots;
+        size_t old_cap = shard->cap;
+        shard->slots = slots;
+        shard->cap = cap;
+        for (size_t i = 0; i < old_cap; i++) {
+            if (old[i].used) {
+                size_t mask = cap - 1;
+                size_t j = (index_hash(old[i].dev, old[i].ino, old[i].kind) >> 4) & mask;
+                while (slots[j].used) {
+                    j = (j + 1) & mask;
+                }
+                slots[j] = old[i];
+            }
+        }
+        free(old);
+    }
+
+    IndexEntry *e = index_probe(shard, h, id, kind, name);
+    if (!e->used) {
+        e->dev = id->dev;
+        e->ino = id->ino;
+        e->gen = id->gen;
+        e->kind = kind;
+        e->name = name;
+        e->used = 1;
+        shard->count++;
+    }
+    pthread_rwlock_unlock(&shard->lock);
+}
+
+// 색인에 추가 + 저널 모드면 저널에도 (예전 백업 디렉터리를 처음 읽을 때, 다음 시작부터는 스캔 안 함)
+static void index_load_add(const BackupId *id, int kind, uint64_t name) {
+    backup_index_add(id, kind, name);
+    if (g_journal) {
+        JournalEntry e = { .dev = id->dev, .ino = id->ino, .gen = id->gen, .kind = kind, .name = name };
+        journal_record(&e);
+    }
+}
+
+/* 시작 시 백업 디렉터리를 읽어 색인 채움 (저널이 없을 때만)
+ - ino-<dev>-<ino>: 이름에서 바로
+ - 그 외 이름 백업: 백엔드 최상위의 같은 이름 파일 (write 경로의 파일명 규칙과 같은 대상) */
+static void backup_index_load(const char *target_path) {
+    DIR *dp = opendir(g_backup_dir);
+    if (dp == NULL) {
+        return;
+    }
+    int target_fd = open(target_path, O_RDONLY | O_DIRECTORY);
+    size_t loaded = 0;
+    struct dirent *de;
+    while ((de = readdir(dp)) != NULL) {
+        unsigned long dev, ino;
+        BackupId id = { 0 };
+        if (sscanf(de->d_name, "ino-%lx-%lx", &dev, &ino) == 2) {
+            id.dev = dev;
+            id.ino = ino;
+            index_load_add(&id, BACKUP_BY_INODE, 0);
+            loaded++;
+            continue;
+        }
+        if (de->d_name[0] == '.' || strncmp(de->d_name, "undo-", 5) == 0 || target_fd == -1) {
+            continue;
+        }
+        int fd = openat(target_fd, de->d_name, O_RDONLY | O_NOFOLLOW | O_NONBLOCK);
+        if (fd == -1) {
+            continue;
+        }
+        if (restore_file_id(fd, &id) == 0) {
+            index_load_add(&id, BACKUP_BY_NAME, index_name(de->d_name));
+            loaded++;
+        }
+        close(fd);
+    }
+    if (target_fd != -1) {
+        close(target_fd);
+    }
+    closedir(dp);
+    if (g_journal) {
+        journal_sync();
+    }
+    fprintf(stderr, "RESTORE: 백업 색인 %zu개 로드\n", loaded);
+}
+
+void restore_set_dedup(int on) {
+    g_dedup = on;
+}
+
+void restore_set_compress(int on) {
+    g_compress = on;
+}
+
+void restore_set_versions(int on, uint64_t quota_bytes, unsigned max_age_s) {
+    g_versions = on;
+    g_version_quota = quota_bytes;
+    g_version_max_age = max_age_s;
+}
+
+void restore_set_quarantine(int on, unsigned max_age_s) {
+    g_quarantine = on;
+    g_quarantine_age = max_age_s;
+}
+
+void restore_set_journal(int on) {
+    g_journal = on;
+}
+
+// 저널 재생 항목 -> 백업 색인
+static void index_journal(const JournalEntry *e, void *arg) {
+    (void)arg;
+    BackupId id = { .dev = e->dev, .ino = e->ino, .gen = e->gen };
+    backup_index_add(&id, e->kind, e->name);
+}
+
+// 청크 저장소의 매니페스트 -> 백업 색인 (키가 inode 이름이면 그대로, 아니면 백엔드 상대 경로)
+static void index_manifest(const char *key, void *arg) {
+    int target_fd = *(int *)arg;
+    unsigned long dev, ino;
+    BackupId id = { 0 };
+    if (sscanf(key, "ino-%lx-%lx", &dev, &ino) == 2) {
+        id.dev = dev;
+        id.ino = ino;
+        backup_index_add(&id, BACKUP_BY_INODE, 0);
+        return;
+    }
+    int fd = target_fd == -1 ? -1 : openat(target_fd, key, O_RDONLY | O_NOFOLLOW | O_NONBLOCK);
+    if (fd != -1) {
+        if (restore_file_id(fd, &id) == 0) {
+            backup_index_add(&id, BACKUP_BY_NAME, index_name(key));
+        }
+        close(fd);
+    }
+}
 
 // 백업 경로 설정 및 생성 함수 (초기화)
 int restore_init(const char *home_dir, const char *target_path) {
@@ -46,15 +300,167 @@ int restore_init(const char *home_dir, const char *target_path) {
     }
     
     fprintf(stderr, "RESTORE: 백업 경로 초기화 완료: %s\n", g_backup_dir);
+    int journal = g_journal ? journal_open(g_backup_dir, index_journal, NULL) : 1;
+    if (journal == -1) {
+        fprintf(stderr, "RESTORE: 백업 저널 사용 불가, 백업본 바로 생성 / 시작 시 디렉터리 스캔\n");
+        g_journal = 0;
+    }
+    if (journal != 0) {
+        backup_index_load(target_path); // 저널 없음 (또는 처음): 디렉터리 스캔, 저널 모드면 저널로 옮김
+    }
+    if (g_versions || g_quarantine) {
+        if (versions_init(g_backup_dir, g_version_quota, g_version_max_age, g_quarantine_age) == 0) {
+            g_version_store = 1;
+        } else {
+            fprintf(stderr, "RESTORE: 버전 저장소 사용 불가, 처음 한 번만 백업 / 격리 안 함\n");
+            g_versions = 0;
+            g_quarantine = 0;
+        }
+    }
+    if (g_dedup) {
+        int target_fd = open(target_path, O_RDONLY | O_DIRECTORY);
+        if (chunk_store_init(g_backup_dir, index_manifest, &target_fd) != 0) {
+            fprintf(stderr, "RESTORE: 청크 저장소 사용 불가, 파일 복사 백업 사용\n");
+            g_dedup = 0;
+        }
+        if (target_fd != -1) {
+            close(target_fd);
+        }
+    }
     
     return 0;
 }
 
-// 백업파일 생성
-void restore_backup_on_write(const char *path, int base_fd) {
+void restore_start_workers(void) {
+    if (g_version_store) {
+        versions_start_evictor();
+    }
+}
+
+const char *restore_backup_dir(void) {
+    return g_backup_dir;
+}
+
+int restore_file_id(int fd, BackupId *id) {
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        return -1;
+    }
+    id->dev = st.st_dev;
+    id->ino = st.st_ino;
+    id->gen = 0;
+#ifdef FS_IOC_GETVERSION
+    long gen = 0; // 커널은 int 만 채움 (0 으로 초기화해서 나머지 바이트 정리)
+    if (ioctl(fd, FS_IOC_GETVERSION, &gen) == 0) {
+        id->gen = (uint32_t)gen;
+    }
+#endif
+    return 0;
+}
+
+/* 청크 저장소 백업 (파일명이 아니라 전체 상대 경로가 키 -> /a/x 와 /b/x 가 충돌하지 않음)
+ 같은 내용의 청크는 이미 있으면 다시 쓰지 않으므로 비슷한 파일이 많을수록 새로 쓰는 양이 줄어듦 */
+static int backup_dedup(const char *relpath, int base_fd, int check_exists) {
+    if (check_exists && chunk_store_has(relpath)) {
+        return 0;
+    }
+    struct timeval start_time, end_time;
+    gettimeofday(&start_time, NULL);
+
+    int src_fd = openat(base_fd, relpath, O_RDONLY);
+    if (src_fd == -1) {
+        fprintf(stderr, "RESTORE: 경고: 백업 위한 파일 %s 열기 불가: %s\n", relpath, strerror(errno));
+        return -1;
+    }
+    ChunkStoreStats stats;
+    int ret = chunk_store_backup(src_fd, relpath, &stats);
+    close(src_fd);
+
+    gettimeofday(&end_time, NULL);
+    long elapsed_us = (end_time.tv_sec - start_time.tv_sec) * 1000000L +
+                      (end_time.tv_usec - start_time.tv_usec);
+    if (ret != 0) {
+        fprintf(stderr, "RESTORE: 청크 백업 에러: %s\n", relpath);
+    } else if (stats.chunks > 0) {
+        fprintf(stderr, "RESTORE: 청크 백업: %s: %llu 바이트 중 %llu 바이트 새로 저장 (청크 %llu/%llu), %ld us\n",
+                relpath, (unsigned long long)stats.file_bytes, (unsigned long long)stats.new_bytes,
+                (unsigned long long)stats.new_chunks, (unsigned long long)stats.chunks, elapsed_us);
+    }
+    return ret;
+}
+
+/* 버전 백업: 이미 백업본이 있어도 이번 쓰기 세션 직전 내용을 새 버전으로 저장
+ (압축 모드면 backup_copy 가 그대로 압축) */
+static int backup_version(const char *relpath, int base_fd, pid_t pid) {
+    struct timeval start_time, end_time;
+    gettimeofday(&start_time, NULL);
+
+    int src_fd = openat(base_fd, relpath, O_RDONLY);
+    if (src_fd == -1) {
+        fprintf(stderr, "RESTORE: 경고: 백업 위한 파일 %s 열기 불가: %s\n", relpath, strerror(errno));
+        return -1;
+    }
+    VersionTicket ticket;
+    if (versions_begin(relpath, pid, &ticket) != 0) {
+        fprintf(stderr, "RESTORE: 경고: 버전 백업 파일 생성 불가: %s\n", relpath);
+        close(src_fd);
+        return -1;
+    }
+    const char *method = "";
+    int ret = backup_copy(src_fd, ticket.fd, &method);
+    close(src_fd);
+    if (versions_commit(&ticket, ret == 0) != 0) {
+        ret = -1;
+    }
+
+    gettimeofday(&end_time, NULL);
+    long elapsed_us = (end_time.tv_sec - start_time.tv_sec) * 1000000L +
+                      (end_time.tv_usec - start_time.tv_usec);
+    if (ret == 0) {
+        fprintf(stderr, "RESTORE: 버전 백업: %s (pid %d), %ld us (%s)\n", relpath, (int)pid, elapsed_us, method);
+    } else {
+        fprintf(stderr, "RESTORE: 버전 백업 쓰기 에러: %s\n", relpath);
+    }
+    return ret;
+}
+
+/* 저널 백업: 임시 파일(.pending-<seq>)에 복사 -> 최종 이름으로 link + COMPLETE 기록 (backup_journal.c)
+ 중간에 죽으면 임시 파일만 남고 (다음 시작 때 지움) 최종 이름에는 다 쓴 백업본만 생김
+ - id 가 NULL 이면 src_fd 로 구함
+ - 반환: 0 = 새로 만듦, 1 = 이미 있음 (다른 스레드가 먼저 만듦), -1 = 실패 */
+static int backup_journaled(int src_fd, const char *backup_filepath, const BackupId *id, int kind, uint64_t name,
+                            const char **method) {
+    BackupId fid;
+    if (id == NULL) {
+        if (restore_file_id(src_fd, &fid) != 0) {
+            return -1;
+        }
+        id = &fid;
+    }
+    JournalTicket ticket;
+    if (journal_begin(&ticket) != 0) {
+        fprintf(stderr, "RESTORE: 경고: 백업 임시 파일 생성 불가 (%s): %s\n", backup_filepath, strerror(errno));
+        return -1;
+    }
+    JournalEntry e = { .dev = id->dev, .ino = id->ino, .gen = id->gen, .kind = kind, .name = name };
+    int ret = backup_copy(src_fd, ticket.fd, method);
+    return journal_commit(&ticket, backup_filepath, &e, ret == 0);
+}
+
+/* 백업파일 생성
+ - check_exists: 백업본이 있는지 stat 으로 먼저 확인 (색인을 쓰면 생략, O_EXCL 이 EEXIST 로 알려줌)
+ - pid: 쓰려는 프로세스 (버전 모드에서 복구할 버전 고르는 데 씀, 모르면 -1)
+ - 반환: 0 = 백업본 있음 (이번에 만들었거나 이미 있음), -1 = 실패 */
+static int backup_by_name(const char *path, int base_fd, int check_exists, pid_t pid) {
     //루트 디렉토리(/)자체는 백업하지 않게 함
     if (strcmp(path, "/") == 0) {
-        return;
+        return 0;
+    }
+    if (g_versions) {
+        return backup_version(path[0] == '/' ? path + 1 : path, base_fd, pid);
+    }
+    if (g_dedup) {
+        return backup_dedup(path[0] == '/' ? path + 1 : path, base_fd, check_exists);
     }
     //파일이름 추출
     const char *filename = strrchr(path, '/');
@@ -66,13 +472,20 @@ void restore_backup_on_write(const char *path, int base_fd) {
 
     // 백업 파일 경로 설정
     char backup_filepath[PATH_MAX];
-    snprintf(backup_filepath, PATH_MAX, "%s/%s", g_backup_dir, filename);
+    if (snprintf(backup_filepath, PATH_MAX, "%s/%s", g_backup_dir, filename) >= PATH_MAX) {
+        fprintf(stderr, "RESTORE: 경고: 백업 경로가 너무 김: %s\n", path);
+        return -1;
+    }
 
     // 백업본 이미 있는지 확인
     struct stat st;
-    if (stat(backup_filepath, &st) != -1) {
-        return;
+    if (check_exists && stat(backup_filepath, &st) != -1) {
+        return 0;
 }
+    // 저널 모드는 O_EXCL 대신 다 쓴 뒤 link 하므로, 색인에 없던 파일은 복사 전에 한 번 확인 (같은 이름의 다른 파일 등)
+    if (g_journal && !check_exists && access(backup_filepath, F_OK) == 0) {
+        return 0;
+    }
 
     //백업 시작(시간 측정 확인)
     struct timeval start_time, end_time;
@@ -91,41 +504,122 @@ void restore_backup_on_write(const char *path, int base_fd) {
     int src_fd = openat(base_fd, relpath, O_RDONLY);
     if (src_fd == -1) {
         fprintf(stderr, "RESTORE: 경고: 백업 위한 파일 %s 열기 불가: %s\n", relpath, strerror(errno));
-        return;
+        return -1;
     }
 
-    //백업 파일 생성 (O_EXCL: 파일이 이미 있으면 열지말고 에러처리)
-    int dest_fd = open(backup_filepath, O_WRONLY | O_CREAT | O_EXCL, 0600);
-    if (dest_fd == -1) {
+    const char *method = "";
+    int ret;
+    if (g_journal) {
+        ret = backup_journaled(src_fd, backup_filepath, NULL, BACKUP_BY_NAME, index_name(path), &method);
         close(src_fd);
-        fprintf(stderr, "RESTORE: 경고: 백업파일 생성 불가 %s: %s\n", backup_filepath, strerror(errno));
-        return;
-    }
+        if (ret == 1) {
+            return 0;
+        }
+    } else {
+        //백업 파일 생성 (O_EXCL: 파일이 이미 있으면 열지말고 에러처리)
+        int dest_fd = open(backup_filepath, O_WRONLY | O_CREAT | O_EXCL, 0600);
+        if (dest_fd == -1) {
+            close(src_fd);
+            if (errno == EEXIST && !check_exists) {
+                return 0;
+            }
+            fprintf(stderr, "RESTORE: 경고: 백업파일 생성 불가 %s: %s\n", backup_filepath, strerror(errno));
+            return -1;
+        }
 
-    //데이터 복사
-    if (copy_file_data(src_fd, dest_fd) == 0) {
+        //데이터 복사
+        ret = backup_copy(src_fd, dest_fd, &method);
+        if (ret != 0) {
+            // 복사 실패 시 생성된 파일 삭제
+            unlink(backup_filepath);
+        }
+        close(src_fd);
+        close(dest_fd);
+    }
+    if (ret == 0) {
         fprintf(stderr, "RESTORE: 오리지널 파일 백업: %s\n", path);
     } else {
-        // 복사 실패 시 생성된 파일 삭제
-        unlink(backup_filepath);
         fprintf(stderr, "RESTORE: 백업 파일 쓰기 에러: %s\n", path);
     }
-    close(src_fd);
-    close(dest_fd);
 
     //시간 측정 결과 출력
     gettimeofday(&end_time, NULL); 
     long elapsed_us = (end_time.tv_sec - start_time.tv_sec) * 1000000L + 
                       (end_time.tv_usec - start_time.tv_usec);
-    fprintf(stderr, "RESTORE: Backup/CoW time for %s: %ld us\n", path, elapsed_us);
+    fprintf(stderr, "RESTORE: Backup/CoW time for %s: %ld us (%s)\n", path, elapsed_us, method);
+    return ret;
+}
+
+int restore_quarantine(const char *path, int base_fd, pid_t pid, int move, uint64_t *token) {
+    if (!g_quarantine || strcmp(path, "/") == 0) {
+        return -1;
+    }
+    const char *relpath = path[0] == '/' ? path + 1 : path;
+    if (versions_quarantine(base_fd, relpath, pid, move, token) != 0) {
+        return -1;
+    }
+    fprintf(stderr, "RESTORE: %s 전 격리: %s (pid %d)\n", move ? "삭제" : "덮어쓰기", path, (int)pid);
+    return 0;
+}
+
+void restore_unquarantine(const char *path, pid_t pid, uint64_t token) {
+    versions_unquarantine(path[0] == '/' ? path + 1 : path, pid, token);
+    fprintf(stderr, "RESTORE: 격리 취소: %s (pid %d)\n", path, (int)pid);
+}
+
+void restore_backup_on_write(const char *path, int base_fd) {
+    backup_by_name(path, base_fd, 1, -1);
+}
+
+int restore_backup_on_write_id(const char *path, int base_fd, const BackupId *id, pid_t pid) {
+    if (id == NULL || g_versions) {
+        return backup_by_name(path, base_fd, 1, pid); // 버전 모드: 세션마다 새 버전 (색인으로 건너뛰지 않음)
+    }
+    uint64_t name = index_name(path);
+    if (backup_index_contains(id, BACKUP_BY_NAME, name)) {
+        return 0; // 흔한 경우: 시스템 콜 없이 메모리 조회 한 번
+    }
+    if (backup_by_name(path, base_fd, 0, pid) != 0) {
+        return -1;
+    }
+    backup_index_add(id, BACKUP_BY_NAME, name);
+    return 0;
 }
 
 //복구 함수
-void restore_backup_file(const char *path, int base_fd) {
+int restore_backup_file(const char *path, int base_fd) {
+    return restore_backup_file_for(path, base_fd, -1);
+}
+
+// 버전 백업으로 복구 (버전이 없으면 -2 -> 이전 방식 백업본으로)
+static int restore_version(const char *path, const char *relpath, int base_fd, pid_t pid) {
+    int src_fd = versions_open(relpath, pid);
+    if (src_fd == -1) {
+        return -2;
+    }
+    int dest_fd = openat(base_fd, relpath, O_WRONLY | O_TRUNC | O_CREAT, 0644);
+    if (dest_fd == -1) {
+        close(src_fd);
+        perror("RESTORE: 복구 실패: 원본 파일 열기 오류");
+        return -1;
+    }
+    const char *method = "";
+    int ret = restore_copy(src_fd, dest_fd, &method);
+    if (ret == 0) {
+        fprintf(stderr, "RESTORE: 복구 성공! 버전 백업으로 복구됨: %s (%s)\n", path, method);
+    } else {
+        fprintf(stderr, "RESTORE: 복구 중 데이터 복사 오류: %s\n", path);
+    }
+    close(src_fd);
+    close(dest_fd);
+    return ret;
+}
+
+int restore_backup_file_for(const char *path, int base_fd, pid_t pid) {
     
     //루트 디렉토리(/) 자체는 복구 대상 아님
     if (strcmp(path, "/") == 0) {
-        return;
+        return -1;
     }
 
     //파일 이름 추출
@@ -138,7 +632,10 @@ void restore_backup_file(const char *path, int base_fd) {
 
     //백업 파일 경로 설정
     char backup_filepath[PATH_MAX];
-    snprintf(backup_filepath, PATH_MAX, "%s/%s", g_backup_dir, filename);
+    if (snprintf(backup_filepath, PATH_MAX, "%s/%s", g_backup_dir, filename) >= PATH_MAX) {
+        fprintf(stderr, "RESTORE: 복구 실패: 백업 경로가 너무 김: %s\n", path);
+        return -1;
+    }
 
     // 원본 파일의 상대 경로 설정 (openat용)
     char relpath[PATH_MAX];
@@ -150,10 +647,33 @@ void restore_backup_file(const char *path, int base_fd) {
         relpath[PATH_MAX - 1] = '\0';
     }
 
+    // 버전 백업/격리본이 있으면 그것으로 (버전 모드 전에 만든 파일은 아래 예전 방식)
+    if (g_version_store) {
+        int ret = restore_version(path, relpath, base_fd, pid);
+        if (ret != -2) {
+            return ret;
+        }
+    }
+
+    // 청크 저장소에 매니페스트가 있으면 그것으로 다시 만듦 (없으면 이전 방식 백업본)
+    if (g_dedup && chunk_store_has(relpath)) {
+        int dest_fd = openat(base_fd, relpath, O_WRONLY | O_CREAT, 0644);
+        int ret = dest_fd == -1 ? -1 : chunk_store_restore(relpath, dest_fd);
+        if (ret != 0) {
+            fprintf(stderr, "RESTORE: 청크 저장소 복구 실패: %s\n", path);
+        } else {
+            fprintf(stderr, "RESTORE: 복구 성공! 매니페스트로 원본 재구성: %s\n", path);
+        }
+        if (dest_fd != -1) {
+            close(dest_fd);
+        }
+        return ret;
+    }
+
     struct stat st;
     if (stat(backup_filepath, &st) == -1) {
         fprintf(stderr, "RESTORE: 복구 실패: 백업 파일 %s 없음\n", backup_filepath);
-        return;
+        return -1;
     }
 
     //복구 시작 (시간 측정)
@@ -165,7 +685,7 @@ void restore_backup_file(const char *path, int base_fd) {
     int src_fd = open(backup_filepath, O_RDONLY);
     if (src_fd == -1) {
         perror("RESTORE: 복구 실패: 백업 파일 열기 오류");
-        return;
+        return -1;
     }
 
     // 원본(target) 파일 열기 (덮어쓰기 + 생성)
@@ -175,11 +695,13 @@ void restore_backup_file(const char *path, int base_fd) {
     if (dest_fd == -1) {
         close(src_fd);
         perror("RESTORE: 복구 실패: 원본 파일 열기 오류");
-        return;
+        return -1;
     }
 
     //데이터 복사 (복구 실행)
-    if (copy_file_data(src_fd, dest_fd) == 0) {
+    const char *method = "";
+    int ret = restore_copy(src_fd, dest_fd, &method);
+    if (ret == 0) {
         fprintf(stderr, "RESTORE: 복구 성공! 파일이 원본으로 복구됨: %s\n", path);
     } else {
         fprintf(stderr, "RESTORE: 복구 중 데이터 복사 오류: %s\n", path);
@@ -192,35 +714,274 @@ void restore_backup_file(const char *path, int base_fd) {
     gettimeofday(&end_time, NULL);
     long elapsed_us = (end_time.tv_sec - start_time.tv_sec) * 1000000L +
                       (end_time.tv_usec - start_time.tv_usec);
-    fprintf(stderr, "RESTORE: 복구 소요 시간: %s: %ld us\n", path, elapsed_us);
+    fprintf(stderr, "RESTORE: 복구 소요 시간: %s: %ld us (%s)\n", path, elapsed_us, method);
+    return ret;
 }
 
+// inode 기준 백업 파일 경로, 반환: 0, 경로가 PATH_MAX 를 넘으면 -1
+static int inode_backup_path(char *out, dev_t dev, ino_t ino) {
+    return snprintf(out, PATH_MAX, "%s/ino-%lx-%lx", g_backup_dir, (unsigned long)dev,
+                    (unsigned long)ino) < PATH_MAX ? 0 : -1;
+}
 
-//카피 파일 복사 함수
-static int copy_file_data(int src_fd, int dest_fd) {
-    #define CHUNK_SIZE 4096 //4KB단위 복사
-    char chunk[CHUNK_SIZE];
-    ssize_t bytes_read;
+// inode 기준 백업 (이미 있으면 처음 원본 유지)
+void restore_backup_fd(int src_fd, dev_t dev, ino_t ino) {
+    BackupId id = { .dev = dev, .ino = ino };
+    if (backup_index_contains(&id, BACKUP_BY_INODE, 0)) {
+        return;
+    }
+    if (g_dedup) {
+        char key[64];
+        snprintf(key, sizeof(key), "ino-%lx-%lx", (unsigned long)dev, (unsigned long)ino);
+        if (chunk_store_backup(src_fd, key, NULL) == 0) {
+            backup_index_add(&id, BACKUP_BY_INODE, 0);
+        }
+        return;
+    }
+    char backup_filepath[PATH_MAX];
+    if (inode_backup_path(backup_filepath, dev, ino) != 0) {
+        fprintf(stderr, "RESTORE: 경고: 백업 경로가 너무 김: inode %lu\n", (unsigned long)ino);
+        return;
+    }
+
+    if (g_journal) {
+        if (access(backup_filepath, F_OK) == 0) {
+            backup_index_add(&id, BACKUP_BY_INODE, 0);
+            return;
+        }
+        int ret = backup_journaled(src_fd, backup_filepath, &id, BACKUP_BY_INODE, 0, NULL);
+        if (ret == 0) {
+            fprintf(stderr, "RESTORE: 오리지널 파일 백업: inode %lu\n", (unsigned long)ino);
+        } else if (ret == -1) {
+            fprintf(stderr, "RESTORE: 백업 파일 쓰기 에러: inode %lu\n", (unsigned long)ino);
+            return;
+        }
+        backup_index_add(&id, BACKUP_BY_INODE, 0);
+        return;
+    }
+    int dest_fd = open(backup_filepath, O_WRONLY | O_CREAT | O_EXCL, 0600);
+    if (dest_fd == -1) {
+        if (errno != EEXIST) {
+            fprintf(stderr, "RESTORE: 경고: 백업파일 생성 불가 %s: %s\n", backup_filepath, strerror(errno));
+        } else {
+            backup_index_add(&id, BACKUP_BY_INODE, 0);
+        }
+        return;
+    }
+    if (backup_copy(src_fd, dest_fd, NULL) == 0) {
+        fprintf(stderr, "RESTORE: 오리지널 파일 백업: inode %lu\n", (unsigned long)ino);
+        backup_index_add(&id, BACKUP_BY_INODE, 0);
+    } else {
+        unlink(backup_filepath);
+        fprintf(stderr, "RESTORE: 백업 파일 쓰기 에러: inode %lu\n", (unsigned long)ino);
+    }
+    close(dest_fd);
+}
 
-    //원본 파일 포인터를 맨 앞으로
-    if (lseek(src_fd, 0, SEEK_SET)==-1){
-        perror("RESTORE: 파일 찾기 오류 발생");
+// inode 기준 복구 (dest_fd 내용을 백업본으로 덮어씀)
+void restore_file_fd(int dest_fd, dev_t dev, ino_t ino) {
+    char backup_filepath[PATH_MAX];
+
+    if (g_dedup) {
+        char key[64];
+        snprintf(key, sizeof(key), "ino-%lx-%lx", (unsigned long)dev, (unsigned long)ino);
+        if (chunk_store_has(key)) {
+            if (chunk_store_restore(key, dest_fd) == 0) {
+                fprintf(stderr, "RESTORE: 복구 성공! 매니페스트로 원본 재구성: inode %lu\n", (unsigned long)ino);
+            } else {
+                fprintf(stderr, "RESTORE: 청크 저장소 복구 실패: inode %lu\n", (unsigned long)ino);
+            }
+            return;
+        }
+    }
+
+    int src_fd = inode_backup_path(backup_filepath, dev, ino) == 0 ? open(backup_filepath, O_RDONLY) : -1;
+    if (src_fd == -1) {
+        fprintf(stderr, "RESTORE: 복구 실패: inode %lu 백업 파일 없음\n", (unsigned long)ino);
+        return;
+    }
+    if (ftruncate(dest_fd, 0) == -1 || lseek(dest_fd, 0, SEEK_SET) == -1) {
+        perror("RESTORE: 복구 실패: 원본 파일 초기화 오류");
+    } else if (restore_copy(src_fd, dest_fd, NULL) == 0) {
+        fprintf(stderr, "RESTORE: 복구 성공! 파일이 원본으로 복구됨: inode %lu\n", (unsigned long)ino);
+    } else {
+        fprintf(stderr, "RESTORE: 복구 중 데이터 복사 오류: inode %lu\n", (unsigned long)ino);
+    }
+    close(src_fd);
+}
+
+#define COPY_NEXT 1                  // 이 방법은 지원 안 됨 -> 다음 방법으로
+#define COPY_CHUNK_MAX (1L << 30)    // copy_file_range/sendfile 한 번에 넘기는 최대 크기
+#define COPY_BUF_SIZE (1024 * 1024)  // 마지막 read/write 루프 버퍼 (1MB)
+
+// 파일시스템/커널이 그 방법을 못 하는 경우 (오류가 아니라 다음 방법으로 넘어감)
+static int copy_unsupported(int err) {
+    return err == EOPNOTSUPP || err == EXDEV || err == EINVAL || err == ENOSYS || err == ENOTTY || err == EPERM;
+}
+
+// 1) reflink: 같은 btrfs/XFS 안이면 데이터 복사 없이 익스텐트만 공유 (크기와 상관없이 즉시)
+static int copy_clone(int src_fd, int dest_fd) {
+#ifdef FICLONE
+    if (ioctl(dest_fd, FICLONE, src_fd) == 0) {
+        return 0;
+    }
+    return copy_unsupported(errno) ? COPY_NEXT : -1;
+#else
+    (void) src_fd;
+    (void) dest_fd;
+    return COPY_NEXT;
+#endif
+}
+
+// 2) copy_file_range: 커널 안에서 복사 (NFS/SMB 는 서버 쪽 복사, 사용자 공간 버퍼 없음)
+static int copy_range(int src_fd, int dest_fd, off_t size) {
+    loff_t in = 0, out = 0;
+    for (;;) {
+        ssize_t n = copy_file_range(src_fd, &in, dest_fd, &out, COPY_CHUNK_MAX, 0);
+        if (n > 0) {
+            continue;
+        }
+        if (n == 0) {
+            // 예전 커널은 지원 못 하는 파일에서 오류 대신 0 을 돌려줌
+            return in < size ? COPY_NEXT : 0;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        return copy_unsupported(errno) ? COPY_NEXT : -1;
+    }
+}
+
+// 3) sendfile: 커널 안에서 페이지 캐시 -> 대상 파일 (dest_fd 는 현재 위치에 씀)
+static int copy_sendfile(int src_fd, int dest_fd, off_t size) {
+    off_t in = 0;
+    if (lseek(dest_fd, 0, SEEK_SET) == -1) {
+        return COPY_NEXT;
+    }
+    for (;;) {
+        ssize_t n = sendfile(dest_fd, src_fd, &in, COPY_CHUNK_MAX);
+        if (n > 0) {
+            continue;
+        }
+        if (n == 0) {
+            return in < size ? COPY_NEXT : 0;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        return copy_unsupported(errno) ? COPY_NEXT : -1;
+    }
+}
+
+/* 백업본 만들기: 압축 모드면 원본 표본 엔트로피로 방식을 골라 블록 단위로 압축
+ 압축할 필요 없는 데이터 (엔트로피 높음) 는 reflink/copy_file_range 등 빠른 복사 그대로
+ 원본이 우연히 압축본 헤더로 시작하면 복구 때 압축본으로 오인되지 않도록 압축본 형식(그대로 저장)으로 씀 */
+static int backup_copy(int src_fd, int dest_fd, const char **method) {
+    double entropy = 0;
+    int codec = g_compress ? codec_choose(src_fd, &entropy) : CODEC_NONE;
+    if (codec == CODEC_NONE && !codec_is_packed(src_fd)) {
+        return copy_file_data(src_fd, dest_fd, method);
+    }
+    uint64_t packed = 0;
+    if (codec_pack(src_fd, dest_fd, codec, &packed) != 0) {
+        perror("RESTORE: 압축 백업 실패");
+        return -1;
+    }
+    struct stat st;
+    if (fstat(src_fd, &st) == 0) {
+        fprintf(stderr, "RESTORE: 압축 백업 (%s, 엔트로피 %.2f): %lld -> %llu 바이트\n", codec_name(codec),
+                entropy, (long long)st.st_size, (unsigned long long)packed);
+    }
+    if (method != NULL) {
+        *method = codec_name(codec);
+    }
+    return 0;
+}
+
+// 백업본으로 복구: 압축본이면 블록마다 풀어서 원래 위치에 씀
+static int restore_copy(int src_fd, int dest_fd, const char **method) {
+    if (!codec_is_packed(src_fd)) {
+        return copy_file_data(src_fd, dest_fd, method);
+    }
+    if (codec_unpack(src_fd, dest_fd) != 0) {
+        fprintf(stderr, "RESTORE: 압축 백업본 풀기 실패\n");
+        return -1;
+    }
+    if (method != NULL) {
+        *method = "unpack";
+    }
+    return 0;
+}
+
+/* 카피 파일 복사 함수
+ 빠른 방법부터 시도: reflink -> copy_file_range -> sendfile -> io_uring 묶음 제출 -> 1MB 버퍼 read/write
+ 어느 단계든 처음부터 같은 위치에 다시 쓰므로 앞 단계가 중간에 실패해도 결과는 같음
+ - method: 성공한 방법 이름 (시간 로그용, NULL 가능) */
+static int copy_file_data(int src_fd, int dest_fd, const char **method) {
+    struct stat st;
+    if (fstat(src_fd, &st) == -1) {
+        perror("RESTORE: 원본 파일 정보 확인 실패");
+        return -1;
+    }
+
+    static const char *names[] = { "reflink", "copy_file_range", "sendfile" };
+    int ret = COPY_NEXT;
+    for (int tier = 0; tier < 3 && ret == COPY_NEXT; tier++) {
+        if (tier == 0) {
+            ret = copy_clone(src_fd, dest_fd);
+        } else if (tier == 1) {
+            ret = copy_range(src_fd, dest_fd, st.st_size);
+        } else {
+            ret = copy_sendfile(src_fd, dest_fd, st.st_size);
+        }
+        if (ret == 0 && method != NULL) {
+            *method = names[tier];
+        }
+    }
+    if (ret != COPY_NEXT) {
+        if (ret == -1) {
+            perror("RESTORE: 파일 복사 실패");
+        }
+        return ret;
+    }
+
+    // io_uring 엔진이 켜져 있으면 읽기/쓰기를 묶어서 제출 (스레드 링의 등록 버퍼 사용)
+    ret = backend_io_copy(src_fd, dest_fd);
+    if (ret != BACKEND_IO_UNAVAILABLE) {
+        if (ret == -1) {
+            perror("RESTORE: io_uring 복사 실패");
+        } else if (method != NULL) {
+            *method = "io_uring";
+        }
+        return ret;
+    }
+
+    char *chunk = malloc(COPY_BUF_SIZE);
+    if (chunk == NULL) {
+        perror("RESTORE: 복사 버퍼 할당 실패");
         return -1;
     }
+    ssize_t bytes_read;
+    off_t pos = 0;
 
-    //데이터 읽고 쓰기 반복
-    while ((bytes_read = read(src_fd, chunk, CHUNK_SIZE)) > 0)
+    //데이터 읽고 쓰기 반복 (앞 단계가 dest 위치를 옮겼을 수 있으므로 위치 지정)
+    while ((bytes_read = pread(src_fd, chunk, COPY_BUF_SIZE, pos)) > 0)
     {
-        if(write(dest_fd, chunk, bytes_read) != bytes_read){
+        if(pwrite(dest_fd, chunk, bytes_read, pos) != bytes_read){
             perror("RESTORE: 목표 파일에 쓰기 실패");
+            free(chunk);
             return -1;
         }
+        pos += bytes_read;
     }
+    free(chunk);
 
     if (bytes_read == -1) {
         perror("RESTORE: 파일 읽기 실패");
         return -1; 
     }
-    
+    if (method != NULL) {
+        *method = "read/write";
+    }
     return 0; 
 }
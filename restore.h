@@ -2,6 +2,8 @@
 #define RESTORE_H
 
 #include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
 
 /* 복구 모듈 초기화 함수
  fuse가 마운트되기 전에 호출됨(= target열고 base_fd획득 후, 
@@ -10,9 +12,68 @@
  - target_path: fuse백엔드 경로 */
 int restore_init(const char *home_dir, const char *target_path);
 
+/* 백업을 파일 통째 복사 대신 내용 기반 청크 저장소(chunk_store.c)에 저장 (restore_init 전에 호출)
+ - 키가 파일명이 아니라 전체 상대 경로, 같은 청크는 한 번만 저장
+ - 복구 시 매니페스트가 없는 파일은 이전 방식 백업본을 사용 */
+void restore_set_dedup(int on);
+
+/* 복사 백업본을 압축 (HAVE_LZ4/HAVE_ZSTD 빌드, 원본 표본 엔트로피로 zstd/lz4/압축 안 함 선택)
+ - 복구는 압축본 헤더를 보고 알아서 풀기 때문에 이 설정을 바꿔도 예전 백업본 복구 가능 */
+void restore_set_compress(int on);
+
+/* 버전 백업 (backup_versions.c): 처음 한 번이 아니라 쓰기 세션(핸들의 첫 write)마다 새 버전
+ - quota_bytes: 전체 한도 (0 = 무제한), max_age_s: 보관 기간 (0 = 무제한), 정리는 백그라운드 스레드
+ - 청크 저장소/이름 백업보다 우선 (버전이 없는 파일은 예전 백업본으로 복구) */
+void restore_set_versions(int on, uint64_t quota_bytes, unsigned max_age_s);
+
+/* 백업 저널 (backup_journal.c, 기본: 켬): 이름/inode 백업본을 임시 파일에 다 쓴 뒤 link 하고 상태를 저널에 기록
+ - 복사 중에 죽어도 잘린 백업본이 남아 다음 백업을 막지 않음 (시작 시 임시 파일 정리)
+ - 시작 시 백업 디렉터리 대신 스냅샷 mmap + 저널 재생으로 색인 로드, fsync 는 그룹 커밋으로 묶음 */
+void restore_set_journal(int on);
+
 /* CoW(Copy-on-write) 백업 함수
 - myfs_write에서 호출되어 파일이 변조 직전에 원본 백업*/
 void restore_backup_on_write(const char *path, int base_fd);
-void restore_backup_file(const char *path, int base_fd);
+
+/* 격리 (backup_versions.c): unlink/rename 덮어쓰기 직전 파일을 복사 없이 버전 저장소로 (rename/link, 파일 크기 무관)
+ - max_age_s: 격리본 보관 기간 (0 = 무제한), 버전 한도/정리 스레드는 restore_set_versions 설정을 같이 씀
+ - 복구는 restore_backup_file(_for) 가 버전과 같이 찾음 */
+void restore_set_quarantine(int on, unsigned max_age_s);
+/* path 격리
+ - move = 1: unlink 대신 옮김 (성공하면 원래 파일은 이미 없음), move = 0: 덮어쓰일 목적지에 링크만 추가
+ - token: 격리한 버전 (restore_unquarantine 용, NULL 가능)
+ - 반환: 0 = 격리됨, -1 = 꺼져 있음/일반 파일 아님/실패 (호출자가 원래대로 처리) */
+int restore_quarantine(const char *path, int base_fd, pid_t pid, int move, uint64_t *token);
+// 격리 되돌리기 (move = 0 으로 격리한 뒤 rename 이 실패했을 때, 버전 목록에서도 뺌)
+void restore_unquarantine(const char *path, pid_t pid, uint64_t token);
+
+/* 파일 식별자 (백업 색인 키): generation 은 FS_IOC_GETVERSION (지원 안 하면 0)
+ - 같은 inode 번호가 삭제 후 재사용되어도 generation 으로 구분 */
+typedef struct {
+    dev_t dev;
+    ino_t ino;
+    uint32_t gen;
+} BackupId;
+int restore_file_id(int fd, BackupId *id);
+
+/* restore_backup_on_write 와 같지만 백업 여부를 색인에서 확인 (이미 백업된 파일이면 시스템 콜 없음)
+ - id 가 NULL 이면 기존처럼 stat 으로 확인
+ - pid: 쓰려는 프로세스 (버전 모드에서 버전에 기록)
+ - 반환: 0 = 백업본 있음 (호출자가 핸들에 기억해두면 다음 write 는 이것도 생략), -1 = 실패 */
+int restore_backup_on_write_id(const char *path, int base_fd, const BackupId *id, pid_t pid);
+// 백업본으로 path 복구 (0 = 성공, -1 = 백업본 없음/실패)
+int restore_backup_file(const char *path, int base_fd);
+// 버전 모드: pid 가 처음 쓰기 직전의 버전으로 복구 (kill 된 프로세스 기준)
+int restore_backup_file_for(const char *path, int base_fd, pid_t pid);
+// 백업 모듈의 백그라운드 스레드 시작 (버전 정리), fuse 가 데몬화한 뒤 init 콜백에서 호출
+void restore_start_workers(void);
+// restore_init 이 만든 백업 디렉터리 절대 경로 (저널 등 다른 백업 방식도 여기에 둠)
+const char *restore_backup_dir(void);
+
+/* 경로 없이 fd 와 파일 식별자(dev, ino)로 백업/복구 (저수준 엔진 blue2_ll.c 용)
+ - 백업 파일 이름: <백업dir>/ino-<dev>-<ino>
+ - src_fd: 읽을 수 있는 원본 fd, dest_fd: 쓸 수 있는 원본 fd (복구 시 처음부터 덮어씀) */
+void restore_backup_fd(int src_fd, dev_t dev, ino_t ino);
+void restore_file_fd(int dest_fd, dev_t dev, ino_t ino);
 
 #endif
@@ -0,0 +1,322 @@
+#include "rollback.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define TOUCHED_INITIAL 16        // 집합 처음 칸 수 (2의 거듭제곱)
+#define TOUCHED_NAMES_INITIAL 1024 // 경로 버퍼 처음 크기
+
+/* 파일 경로 집합: 경로는 버퍼 하나에 이어 붙이고, 칸에는 버퍼 안 위치만 (칸 하나 4바이트)
+ - 파일마다 malloc 하지 않음, kill 때 버퍼째 워커에 넘김 */
+struct TouchedFiles {
+    char *names;        // '\0' 으로 끝나는 경로들을 이어 붙인 버퍼
+    size_t used, size;
+    uint32_t *slots;    // names 안의 위치 + 1 (0 = 빈 칸), 선형 탐사
+    size_t cap, count;
+};
+
+typedef struct {
+    off_t size;         // 복구 순서용 (현재 파일 크기, 없으면 0)
+    uint32_t name;      // names 안의 위치
+} RollbackItem;
+
+// 프로세스 하나의 복구 작업 (항목은 큰 파일부터)
+typedef struct RollbackBatch {
+    pid_t pid;
+    TouchedFiles *files;
+    RollbackItem *items;
+    size_t count;
+    size_t next;                // 다음에 가져갈 항목
+    size_t done, failed;
+    struct timespec start;
+    struct RollbackBatch *next_batch;
+} RollbackBatch;
+
+// 아래 상태는 모두 g_lock 으로 보호 (복구 하나가 ms 단위라 락 하나로 충분)
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_cond = PTHREAD_COND_INITIALIZER;
+static RollbackBatch *g_head = NULL, *g_tail = NULL; // 아직 가져갈 항목이 남은 작업
+static pthread_t *g_threads = NULL;
+static unsigned g_thread_count = 0;
+static int g_stopping = 0;
+static int g_dirfd = -1;
+static rollback_fn g_fn = NULL;
+
+static _Atomic uint64_t g_pending = 0;
+static _Atomic uint64_t g_done = 0;
+static _Atomic uint64_t g_failed = 0;
+
+// 경로 해시 (FNV-1a)
+static uint64_t path_hash(const char *path) {
+    uint64_t h = 1469598103934665603ULL;
+    for (const unsigned char *p = (const unsigned char *)path; *p; p++) {
+        h ^= *p;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// path 칸 또는 멈춘 빈 칸 위치
+static size_t touched_probe(const TouchedFiles *set, const char *path) {
+    size_t mask = set->cap - 1;
+    for (size_t i = path_hash(path) & mask;; i = (i + 1) & mask) {
+        uint32_t s = set->slots[i];
+        if (s == 0 || strcmp(set->names + s - 1, path) == 0) {
+            return i;
+        }
+    }
+}
+
+static int touched_grow(TouchedFiles *set) {
+    size_t new_cap = set->cap ? set->cap * 2 : TOUCHED_INITIAL;
+    uint32_t *slots = calloc(new_cap, sizeof(uint32_t));
+    if (slots == NULL) {
+        return -1;
+    }
+    uint32_t *old = set->slots;
+    size_t old_cap = set->cap;
+    set->slots = slots;
+    set->cap = new_cap;
+    for (size_t i = 0; i < old_cap; i++) {
+        if (old[i] != 0) {
+            set->slots[touched_probe(set, set->names + old[i] - 1)] = old[i];
+        }
+    }
+    free(old);
+    return 0;
+}
+
+int touched_add(TouchedFiles **setp, const char *path) {
+    TouchedFiles *set = *setp;
+    if (set == NULL) {
+        set = calloc(1, sizeof(*set));
+        if (set == NULL) {
+            return -1;
+        }
+        *setp = set;
+    }
+    if ((set->count + 1) * 4 > set->cap * 3 && touched_grow(set) != 0) {
+        return -1;
+    }
+    size_t i = touched_probe(set, path);
+    if (set->slots[i] != 0) {
+        return 0;
+    }
+
+    size_t len = strlen(path) + 1;
+    if (set->used + len > set->size) {
+        size_t new_size = set->size ? set->size * 2 : TOUCHED_NAMES_INITIAL;
+        while (new_size < set->used + len) {
+            new_size *= 2;
+        }
+        if (new_size > UINT32_MAX) {
+            return -1;
+        }
+        char *names = realloc(set->names, new_size);
+        if (names == NULL) {
+            return -1;
+        }
+        set->names = names;
+        set->size = new_size;
+    }
+    memcpy(set->names + set->used, path, len);
+    set->slots[i] = (uint32_t)(set->used + 1);
+    set->used += len;
+    set->count++;
+    return 1;
+}
+
+size_t touched_count(const TouchedFiles *set) {
+    return set ? set->count : 0;
+}
+
+void touched_free(TouchedFiles *set) {
+    if (set != NULL) {
+        free(set->names);
+        free(set->slots);
+        free(set);
+    }
+}
+
+static int item_cmp(const void *a, const void *b) {
+    off_t x = ((const RollbackItem *)a)->size, y = ((const RollbackItem *)b)->size;
+    return (x < y) - (x > y); // 큰 파일부터
+}
+
+static void batch_free(RollbackBatch *b) {
+    touched_free(b->files);
+    free(b->items);
+    free(b);
+}
+
+// 마지막 항목이 끝난 작업 정리
+static void batch_finish(RollbackBatch *b) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long elapsed_ms = (now.tv_sec - b->start.tv_sec) * 1000L + (now.tv_nsec - b->start.tv_nsec) / 1000000L;
+    fprintf(stderr, "ROLLBACK: PID %d 복구 끝: 파일 %zu개 중 성공 %zu, 실패 %zu (%ld ms)\n",
+            b->pid, b->count, b->done, b->failed, elapsed_ms);
+    batch_free(b);
+}
+
+// 반환: 1 = 이 호출이 작업의 마지막 항목을 끝냄 (호출자가 batch_finish, 증가와 확인을 같은 락 안에서)
+static int item_run(RollbackBatch *b, RollbackItem *item, int locked) {
+    int ok = g_fn(b->files->names + item->name, b->pid) == 0;
+    atomic_fetch_sub_explicit(&g_pending, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(ok ? &g_done : &g_failed, 1, memory_order_relaxed);
+    if (locked) {
+        pthread_mutex_lock(&g_lock);
+    }
+    if (ok) {
+        b->done++;
+    } else {
+        b->failed++;
+    }
+    int last = b->done + b->failed == b->count;
+    if (locked) {
+        pthread_mutex_unlock(&g_lock);
+    }
+    return last;
+}
+
+// 워커: 맨 앞 작업에서 항목을 하나씩 가져감 (여러 워커가 같은 작업을 나눠서 처리)
+static void *rollback_worker(void *arg) {
+    (void) arg;
+    pthread_mutex_lock(&g_lock);
+    for (;;) {
+        while (g_head == NULL && !g_stopping) {
+            pthread_cond_wait(&g_cond, &g_lock);
+        }
+        if (g_head == NULL) {
+            break; // 종료 요청 + 남은 작업 없음
+        }
+        RollbackBatch *b = g_head;
+        RollbackItem *item = &b->items[b->next++];
+        if (b->next == b->count) {
+            g_head = b->next_batch;
+            if (g_head == NULL) {
+                g_tail = NULL;
+            }
+        }
+        pthread_mutex_unlock(&g_lock);
+
+        if (item_run(b, item, 1)) {
+            batch_finish(b); // 큐에서 이미 빠졌고 남은 항목도 없으므로 락 없이
+        }
+        pthread_mutex_lock(&g_lock);
+    }
+    pthread_mutex_unlock(&g_lock);
+    return NULL;
+}
+
+int rollback_start(unsigned workers, int dirfd, rollback_fn fn) {
+    g_dirfd = dirfd;
+    g_fn = fn;
+    if (workers == 0) {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = n > 0 ? (unsigned)n : 1;
+    }
+    g_threads = calloc(workers, sizeof(pthread_t));
+    if (g_threads == NULL) {
+        return -1;
+    }
+    for (unsigned i = 0; i < workers; i++) {
+        if (pthread_create(&g_threads[i], NULL, rollback_worker, NULL) != 0) {
+            fprintf(stderr, "ROLLBACK: 워커 스레드 생성 실패\n");
+            break;
+        }
+        g_thread_count++;
+    }
+    if (g_thread_count == 0) {
+        free(g_threads);
+        g_threads = NULL;
+        return -1; // 요청 스레드에서 직접 복구
+    }
+    fprintf(stderr, "ROLLBACK: 복구 워커 %u개 시작\n", g_thread_count);
+    return 0;
+}
+
+void rollback_stop(void) {
+    pthread_mutex_lock(&g_lock);
+    g_stopping = 1;
+    pthread_cond_broadcast(&g_cond);
+    pthread_mutex_unlock(&g_lock);
+    for (unsigned i = 0; i < g_thread_count; i++) {
+        pthread_join(g_threads[i], NULL);
+    }
+    free(g_threads);
+    g_threads = NULL;
+    g_thread_count = 0;
+    g_stopping = 0;
+}
+
+void rollback_submit(pid_t pid, TouchedFiles *set, const char *path) {
+    if (path != NULL && touched_add(&set, path) < 0) {
+        fprintf(stderr, "ROLLBACK: 메모리 부족, %s 복구 목록에 못 넣음\n", path);
+    }
+    RollbackBatch *b = calloc(1, sizeof(*b));
+    if (set == NULL || set->count == 0 || g_fn == NULL || b == NULL ||
+        (b->items = malloc(set->count * sizeof(RollbackItem))) == NULL) {
+        fprintf(stderr, "ROLLBACK: PID %d 복구 작업을 만들지 못함\n", pid);
+        touched_free(set);
+        free(b);
+        return;
+    }
+    b->pid = pid;
+    b->files = set;
+    clock_gettime(CLOCK_MONOTONIC, &b->start);
+
+    // 큰 파일부터: 마지막에 큰 파일 하나만 남아 워커 하나가 오래 붙잡는 것을 막음
+    for (size_t off = 0; off < set->used; off += strlen(set->names + off) + 1) {
+        const char *p = set->names + off;
+        struct stat st;
+        RollbackItem *item = &b->items[b->count++];
+        item->name = (uint32_t)off;
+        item->size = fstatat(g_dirfd, p[0] == '/' && p[1] ? p + 1 : ".", &st, AT_SYMLINK_NOFOLLOW) == 0
+                         ? st.st_size : 0;
+    }
+    qsort(b->items, b->count, sizeof(RollbackItem), item_cmp);
+    atomic_fetch_add_explicit(&g_pending, b->count, memory_order_relaxed);
+
+    pthread_mutex_lock(&g_lock);
+    unsigned workers = g_thread_count;
+    fprintf(stderr, "ROLLBACK: PID %d 가 수정한 파일 %zu개 복구 시작 (워커 %u)\n", pid, b->count, workers);
+    if (workers > 0) {
+        if (g_tail != NULL) {
+            g_tail->next_batch = b;
+        } else {
+            g_head = b;
+        }
+        g_tail = b;
+        pthread_cond_broadcast(&g_cond);
+    }
+    pthread_mutex_unlock(&g_lock);
+    if (workers > 0) {
+        return;
+    }
+
+    // 워커 없음: 이 스레드에서 순서대로
+    for (size_t i = 0; i < b->count; i++) {
+        item_run(b, &b->items[i], 0);
+    }
+    batch_finish(b);
+}
+
+void rollback_stats(uint64_t *pending, uint64_t *done, uint64_t *failed) {
+    if (pending) {
+        *pending = atomic_load_explicit(&g_pending, memory_order_relaxed);
+    }
+    if (done) {
+        *done = atomic_load_explicit(&g_done, memory_order_relaxed);
+    }
+    if (failed) {
+        *failed = atomic_load_explicit(&g_failed, memory_order_relaxed);
+    }
+}
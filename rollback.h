@@ -0,0 +1,37 @@
+#ifndef ROLLBACK_H
+#define ROLLBACK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/* 악성 판정된 프로세스가 건드린 파일 전체 복구
+ - PID 엔트리(score_table) 마다 수정한 파일 경로 집합 (TouchedFiles) 을 모아둠
+ - kill 판정 시 집합을 통째로 롤백 워커 풀에 넘김 -> 큰 파일부터 여러 워커가 나눠서 복구
+   (파일 하나짜리 복구를 요청 스레드에서 하던 것 대신, 복구 시간이 파일 수가 아니라 코어 수에 비례) */
+
+typedef struct TouchedFiles TouchedFiles;
+
+// 경로 추가 (*set 이 NULL 이면 만듦), 반환: 1 = 새로 추가, 0 = 이미 있음, -1 = 메모리 부족
+int touched_add(TouchedFiles **set, const char *path);
+size_t touched_count(const TouchedFiles *set);
+void touched_free(TouchedFiles *set);
+
+// 파일 하나 복구 (워커 스레드에서 호출, pid: kill 된 프로세스, 0 = 성공)
+typedef int (*rollback_fn)(const char *path, pid_t pid);
+
+/* 롤백 워커 workers 개 시작 (0 = CPU 수)
+ - dirfd: 크기 조회용 백엔드 디렉터리 (경로는 FUSE 경로 "/a/b") */
+int rollback_start(unsigned workers, int dirfd, rollback_fn fn);
+// 남은 복구를 모두 끝낸 뒤 워커 종료
+void rollback_stop(void);
+
+/* pid 의 파일 집합 복구 요청 (set 의 소유권을 넘겨받음, NULL 가능)
+ - path 는 이번에 걸린 요청의 경로 (집합에 없으면 추가)
+ - 워커가 없으면 호출한 스레드에서 바로 복구 */
+void rollback_submit(pid_t pid, TouchedFiles *set, const char *path);
+
+// 대기 중/복구 완료/실패 파일 수
+void rollback_stats(uint64_t *pending, uint64_t *done, uint64_t *failed);
+
+#endif
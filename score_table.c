@@ -0,0 +1,252 @@
+#include "score_table.h"
+#include "rollback.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <math.h>
+
+#define SCORE_SHARDS 64          // 샤드 개수 (2의 거듭제곱)
+#define SCORE_SHARD_INITIAL 16   // 샤드 하나의 처음 칸 수
+#define SCORE_EMPTY ((pid_t)-1)  // 빈 칸 표시
+#define SCORE_HALF_LIFE_DEFAULT 30 // 점수 반감기 기본값 (초)
+
+typedef struct {
+    pthread_mutex_t lock;
+    ProcessScore *slots;
+    size_t cap;     // 칸 수 (2의 거듭제곱)
+    size_t count;   // 사용 중인 칸 수
+} ScoreShard;
+
+static ScoreShard g_shards[SCORE_SHARDS];
+static pthread_once_t g_score_once = PTHREAD_ONCE_INIT;
+static double g_half_life_ms = SCORE_HALF_LIFE_DEFAULT * 1000.0; // 0 = 감쇠 없음
+
+static void score_table_init_once(void) {
+    for (int i = 0; i < SCORE_SHARDS; i++) {
+        pthread_mutex_init(&g_shards[i].lock, NULL);
+    }
+}
+
+static inline uint32_t pid_hash(pid_t pid) {
+    return (uint32_t)pid * 2654435761u; // 피보나치 해싱
+}
+
+static inline ScoreShard *shard_of(pid_t pid) {
+    return &g_shards[pid_hash(pid) & (SCORE_SHARDS - 1)];
+}
+
+static inline size_t home_slot(const ScoreShard *shard, pid_t pid) {
+    return (pid_hash(pid) >> 6) & (shard->cap - 1); // 하위 6비트는 샤드 선택에 썼으니 제외
+}
+
+static ProcessScore *alloc_slots(size_t cap) {
+    ProcessScore *slots = malloc(cap * sizeof(ProcessScore));
+    if (slots == NULL) {
+        return NULL;
+    }
+    for (size_t i = 0; i < cap; i++) {
+        slots[i].pid = SCORE_EMPTY;
+    }
+    return slots;
+}
+
+// 선형 탐사로 pid 칸 찾기 (없으면 멈춘 빈 칸 위치를 돌려주고 NULL)
+static ProcessScore *shard_find(ScoreShard *shard, pid_t pid, size_t *empty_out) {
+    size_t mask = shard->cap - 1;
+    for (size_t i = home_slot(shard, pid);; i = (i + 1) & mask) {
+        if (shard->slots[i].pid == pid) {
+            return &shard->slots[i];
+        }
+        if (shard->slots[i].pid == SCORE_EMPTY) {
+            *empty_out = i;
+            return NULL;
+        }
+    }
+}
+
+// i 번 칸 삭제: 뒤에 이어진 칸들을 당겨서 탐사 사슬이 끊기지 않게 함 (backward shift)
+static void shard_remove_at(ScoreShard *shard, size_t i) {
+    size_t mask = shard->cap - 1;
+    size_t j = i;
+    for (;;) {
+        j = (j + 1) & mask;
+        if (shard->slots[j].pid == SCORE_EMPTY) {
+            break;
+        }
+        size_t home = home_slot(shard, shard->slots[j].pid);
+        // j 의 원래 자리(home)가 (i, j] 구간 밖이면 i 로 옮길 수 있음
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            shard->slots[i] = shard->slots[j];
+            i = j;
+        }
+    }
+    shard->slots[i].pid = SCORE_EMPTY;
+    shard->count--;
+}
+
+// 이미 종료된 프로세스 엔트리 정리
+static size_t shard_evict_dead(ScoreShard *shard) {
+    size_t evicted = 0;
+    size_t i = 0;
+    while (i < shard->cap) {
+        pid_t pid = shard->slots[i].pid;
+        if (pid != SCORE_EMPTY && pid > 0 && kill(pid, 0) == -1 && errno == ESRCH) {
+            touched_free(shard->slots[i].touched);
+            shard_remove_at(shard, i); // 당겨진 칸을 다시 검사해야 하므로 i 유지
+            evicted++;
+            continue;
+        }
+        i++;
+    }
+    return evicted;
+}
+
+static int shard_grow(ScoreShard *shard) {
+    size_t new_cap = shard->cap ? shard->cap * 2 : SCORE_SHARD_INITIAL;
+    ProcessScore *slots = alloc_slots(new_cap);
+    if (slots == NULL) {
+        return -1;
+    }
+    ProcessScore *old = shard->slots;
+    size_t old_cap = shard->cap;
+    shard->slots = slots;
+    shard->cap = new_cap;
+
+    for (size_t i = 0; i < old_cap; i++) {
+        if (old[i].pid == SCORE_EMPTY) {
+            continue;
+        }
+        size_t empty = 0;
+        shard_find(shard, old[i].pid, &empty);
+        shard->slots[empty] = old[i];
+    }
+    free(old);
+    return 0;
+}
+
+ProcessScore *score_table_acquire(pid_t pid, int create) {
+    pthread_once(&g_score_once, score_table_init_once);
+    ScoreShard *shard = shard_of(pid);
+    pthread_mutex_lock(&shard->lock);
+
+    size_t empty = 0;
+    ProcessScore *entry = NULL;
+    if (shard->cap > 0) {
+        entry = shard_find(shard, pid, &empty);
+    }
+    if (entry != NULL) {
+        return entry;
+    }
+    if (!create) {
+        pthread_mutex_unlock(&shard->lock);
+        return NULL;
+    }
+
+    // 새 엔트리: 부하율 3/4 를 넘으면 종료된 프로세스부터 정리하고, 그래도 넘으면 확장
+    if ((shard->count + 1) * 4 > shard->cap * 3) {
+        if (shard->cap == 0 || shard_evict_dead(shard) == 0 || (shard->count + 1) * 4 > shard->cap * 3) {
+            if (shard_grow(shard) != 0) {
+                pthread_mutex_unlock(&shard->lock);
+                fprintf(stderr, "오류: Score 테이블 확장 실패!\n");
+                return NULL;
+            }
+        }
+        shard_find(shard, pid, &empty);
+    }
+
+    entry = &shard->slots[empty];
+    memset(entry, 0, sizeof(*entry));
+    entry->pid = pid;
+    rate_window_init(&entry->rate);
+    entry->last_write_ms = analyzer_now_ms();
+    shard->count++;
+    return entry;
+}
+
+void score_table_release(ProcessScore *entry) {
+    pthread_mutex_unlock(&shard_of(entry->pid)->lock);
+}
+
+void score_table_set_half_life(unsigned seconds) {
+    g_half_life_ms = seconds * 1000.0;
+}
+
+/* score * 2^(-경과시간/반감기)
+ - COARSE 시계라 같은 틱 안의 연산은 경과시간 0 -> exp2 없이 바로 반환
+ - 비동기 워커의 이벤트 시각이 이미 반영된 시각보다 이를 수 있음 -> 시간을 되돌리지 않음 */
+void score_decay(ProcessScore *entry, uint64_t now_ms) {
+    if (now_ms <= entry->last_write_ms) {
+        return;
+    }
+    if (g_half_life_ms > 0 && entry->malice_score != 0) {
+        entry->malice_score *= exp2(-(double)(now_ms - entry->last_write_ms) / g_half_life_ms);
+    }
+    entry->last_write_ms = now_ms;
+}
+
+int update_malice_score(pid_t pid, int added_score) {
+    uint64_t now = analyzer_now_ms();
+    ProcessScore *entry = score_table_acquire(pid, 1);
+    if (entry == NULL) {
+        return 0;
+    }
+    score_decay(entry, now);
+    entry->malice_score += added_score;
+    int score = (int)entry->malice_score;
+    score_table_release(entry);
+    return score;
+}
+
+int get_malice_score(pid_t pid) {
+    uint64_t now = analyzer_now_ms();
+    ProcessScore *entry = score_table_acquire(pid, 0);
+    if (entry == NULL) {
+        return 0; // 엔트리 못 찾으면 0점 반환
+    }
+    score_decay(entry, now);
+    int score = (int)entry->malice_score;
+    score_table_release(entry);
+    return score;
+}
+
+void reset_malice_score(pid_t pid) {
+    ProcessScore *entry = score_table_acquire(pid, 0);
+    if (entry != NULL) {
+        entry->malice_score = 0;
+        score_table_release(entry);
+    }
+}
+
+void score_table_touch(pid_t pid, const char *path) {
+    ProcessScore *entry = score_table_acquire(pid, 1);
+    if (entry != NULL) {
+        touched_add(&entry->touched, path);
+        score_table_release(entry);
+    }
+}
+
+TouchedFiles *score_table_take_touched(pid_t pid) {
+    ProcessScore *entry = score_table_acquire(pid, 0);
+    if (entry == NULL) {
+        return NULL;
+    }
+    TouchedFiles *set = entry->touched;
+    entry->touched = NULL;
+    score_table_release(entry);
+    return set;
+}
+
+size_t score_table_count(void) {
+    pthread_once(&g_score_once, score_table_init_once);
+    size_t total = 0;
+    for (int i = 0; i < SCORE_SHARDS; i++) {
+        pthread_mutex_lock(&g_shards[i].lock);
+        total += g_shards[i].count;
+        pthread_mutex_unlock(&g_shards[i].lock);
+    }
+    return total;
+}
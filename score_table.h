@@ -0,0 +1,51 @@
+#ifndef SCORE_TABLE_H
+#define SCORE_TABLE_H
+
+#include <sys/types.h>
+#include <time.h>
+#include "analyzer.h"
+
+// PID별 Malice Score, 행동 정보 저장할 구조체
+typedef struct {
+    pid_t pid;
+    double malice_score;    // 시간에 따라 반감기로 줄어드는 점수 (last_write_ms 기준으로 필요할 때만 계산)
+    uint64_t last_write_ms; // 마지막으로 점수를 갱신한 시각 (analyzer_now_ms)
+    int kill_pending;       // 분석 워커가 kill 판정을 내렸음 (다음 연산에서 차단)
+    char proc_name[32];     // 프로세스 이름 저장
+    RateWindow rate;        // 연산 종류별 최근 1초 빈도
+    struct TouchedFiles *touched; // 수정한 파일 경로 집합 (kill 때 전체 복구용, rollback.c)
+} ProcessScore;
+
+/* PID -> ProcessScore 해시 테이블 (크기 제한 없음, 멀티스레드 FUSE 에서 안전)
+ - PID 해시로 샤드를 고르고 샤드마다 락 + 오픈 어드레싱 배열
+ - 샤드가 차면 종료된 프로세스 엔트리를 먼저 지우고, 그래도 부족하면 2배로 늘림 */
+
+/* 엔트리를 찾아 샤드를 잠근 채로 반환 (반드시 score_table_release 로 풀어야 함)
+ - create 가 0 이면 없을 때 NULL 반환 (락도 풀린 상태) */
+ProcessScore *score_table_acquire(pid_t pid, int create);
+void score_table_release(ProcessScore *entry);
+
+/* 점수 반감기 설정 (초, 0 = 감쇠 없음)
+ - 파일을 닫을 때마다 점수를 지우던 방식은 열고 닫기를 반복하면 우회되므로,
+   대신 오래된 점수가 천천히 사라지게 함 (백그라운드 스윕 없이 엔트리를 만질 때 계산) */
+void score_table_set_half_life(unsigned seconds);
+// 잠긴 엔트리의 점수를 now_ms 까지 감쇠
+void score_decay(ProcessScore *entry, uint64_t now_ms);
+
+// 점수 추가 후 새 점수 반환 (조회 한 번)
+int update_malice_score(pid_t pid, int added_score);
+// 특정 PID의 Malice Score 반환 (없으면 0)
+int get_malice_score(pid_t pid);
+// 특정 PID의 Score 0으로 초기화
+void reset_malice_score(pid_t pid);
+/* PID 가 수정한 파일 기록 (같은 경로는 한 번만)
+ - take: 집합을 엔트리에서 떼어 반환 (호출자가 rollback_submit 으로 넘기거나 touched_free) */
+void score_table_touch(pid_t pid, const char *path);
+struct TouchedFiles *score_table_take_touched(pid_t pid);
+// 현재 추적 중인 프로세스 개수
+size_t score_table_count(void);
+
+// 잠긴 엔트리에 점수 반영 (analyzer.c, 호출자가 score_table_acquire 로 잡고 있어야 함)
+int analyzer_apply(ProcessScore *entry, int op, int content_score, uint64_t now_ms);
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef UNDO_JOURNAL_H
+#define UNDO_JOURNAL_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+/* 범위 단위 되돌리기 저널 (파일 전체 백업 대신)
+ write 직전에 덮어쓰일 바이트 범위만 저널에 덧붙임 -> 큰 파일의 4KB 수정은 4KB 만 백업
+ - 저널 파일: <백업dir>/undo-<dev>-<ino> (헤더: 처음 크기 + gen/생성 시각, 레코드: offset, len, 원래 데이터)
+ - 레코드는 fdatasync 한 뒤에 덮어씀, inode 번호가 재사용된 파일에는 예전 저널을 쓰지 않음
+ - 파일마다 이미 저장한 범위를 구간 목록으로 기억해서 같은 범위는 한 번만 저장 (처음 원본만 필요)
+ - 처음 크기 뒤쪽(새로 늘어난 부분)은 저장하지 않음, 복구 때 처음 크기로 잘라냄 */
+
+typedef struct UndoFile UndoFile;
+
+/* 파일의 저널 상태 열기 (같은 inode 를 여러 번 열면 같은 상태를 공유, 참조 카운트)
+ - 읽기용 fd 를 따로 엶 (FUSE 핸들이 O_WRONLY 여도 원래 데이터를 읽을 수 있도록)
+ - 저널 파일이 이미 있으면 (데몬 재시작) 읽어서 저장한 범위를 복원 */
+UndoFile *undo_open(int dirfd, const char *relpath);
+void undo_close(UndoFile *uf);
+
+// [offset, offset+size) 를 덮어쓰기 전에 호출 (아직 저장 안 된 부분만 저널에 추가)
+int undo_save(UndoFile *uf, off_t offset, size_t size);
+// ftruncate(new_size) 전에 호출 (잘려나갈 [new_size, 처음 크기) 저장)
+int undo_save_truncate(UndoFile *uf, off_t new_size);
+
+/* 저널을 역순으로 다시 써서 처음 내용으로 되돌림 (kill 시)
+ - 반환: 0 = 복구함, -1 = 저널 없음/실패 */
+int undo_rollback(int dirfd, const char *relpath);
+
+// 마지막 이름이 지워진 파일의 저널 삭제 (unlink, rename 으로 덮어쓴 목적지)
+void undo_discard(dev_t dev, ino_t ino);
+
+#endif